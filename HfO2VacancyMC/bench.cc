@@ -0,0 +1,290 @@
+// Microbenchmark for the HfO2Core hot paths, driven by a synthetic beam-like
+// deposition stream (no Geant4): VoxelGrid::ToIndex / AddEdep /
+// ResetEventAccumulators, VacancyModel::ResetAndInit / ProcessEvent, the
+// dense initial vacancy field, the face-neighbour probe and the CSV / npy exporters. Build with
+// -DHFO2_LAYOUT=... to compare storage layouts.
+//
+// Usage: HfO2CoreBench [key=value ...]
+//   sizes=1e5,1e6,1e7  voxel counts; Nz layers, square Nx = Ny
+//   nz=10, dxyNm=5, dzNm=1    grid pitch (nm)
+//   events=2000, tracks=4     primaries per event
+//   spotNm=0                  Gaussian beam spot sigma (0: 1/8 of the pad)
+//   stepNm=0.3, edepMean_eV=25, deltaProb=0.03   track structure
+//   vacConcCm3=1e19           initial vacancies (materializes every chunk)
+//   exportMax=1e7             dense exports only up to this many voxels
+//   dir=.                     scratch directory for the exports
+//   seed=1
+//
+// Timings are per step (ToIndex, AddEdep), per neighbour (Neighbors6), per touched voxel (binning, record
+// fill and reset at end of event, ProcessEvent), per voxel (ResetAndInit, InitialField) and in GB/s of
+// file for exports.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "VoxelGrid.hh"
+#include "VacancyModel.hh"
+#include "EventRecord.hh"
+
+using hfo2units::nm;
+using hfo2units::eV;
+
+namespace {
+
+struct Options {
+    std::vector<double> sizes{1e5, 1e6, 1e7};
+    int nz = 10;
+    double dxyNm = 5.0, dzNm = 1.0;
+    int events = 2000, tracks = 4;
+    double spotNm = 0.0, stepNm = 0.3, edepMean_eV = 25.0, deltaProb = 0.03;
+    double vacConcCm3 = 1e19;
+    double exportMax = 1e7;
+    std::string dir = ".";
+    uint64_t seed = 1;
+};
+
+struct Step { Vec3 p; double edep; };
+
+// Steps for all events; event e covers steps[offsets[e] .. offsets[e+1])
+struct Stream {
+    std::vector<Step> steps;
+    std::vector<size_t> offsets{0};
+};
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+size_t FileBytes(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    return in ? (size_t)in.tellg() : 0;
+}
+
+// Primaries enter at z = 0 inside a Gaussian spot and cross the oxide with a
+// small lateral wander; each step deposits an exponential amount, and some
+// steps spawn a short delta-ray cluster (random walk around the step point).
+Stream MakeStream(const Options& o, const VoxelGrid& grid) {
+    std::mt19937_64 rng(o.seed);
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    std::exponential_distribution<double> edep(1.0 / o.edepMean_eV);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+
+    const Vec3 lo = grid.Min(), hi = grid.Max();
+    const Vec3 centre = 0.5 * (lo + hi);
+    const double side = hi.x() - lo.x();
+    const double spot = o.spotNm > 0.0 ? o.spotNm * nm : side / 8.0;
+    const double step = o.stepNm * nm;
+
+    Stream s;
+    for (int e = 0; e < o.events; ++e) {
+        for (int t = 0; t < o.tracks; ++t) {
+            double x = centre.x() + spot * gauss(rng);
+            double y = centre.y() + spot * gauss(rng);
+            for (double z = hi.z() - 0.5 * step; z > lo.z(); z -= step) {
+                x += 0.1 * step * gauss(rng);
+                y += 0.1 * step * gauss(rng);
+                s.steps.push_back(Step{Vec3(x, y, z), edep(rng) * eV});
+                if (uni(rng) >= o.deltaProb) continue;
+                Vec3 q(x, y, z);
+                const int n = 5 + (int)(15 * uni(rng));
+                for (int k = 0; k < n; ++k) {
+                    q = q + Vec3(gauss(rng), gauss(rng), gauss(rng)) * (0.5 * nm);
+                    s.steps.push_back(Step{q, edep(rng) * eV});
+                }
+            }
+        }
+        s.offsets.push_back(s.steps.size());
+    }
+    return s;
+}
+
+void Report(const std::string& what, double sec, double count, const std::string& unit) {
+    std::cout << "  " << std::left << std::setw(28) << what << std::right
+              << std::setw(10) << std::fixed << std::setprecision(2) << 1e9 * sec / count
+              << " ns/" << unit << "   (" << std::setprecision(3) << sec << " s)\n";
+}
+
+void ReportExport(const std::string& what, double sec, size_t bytes) {
+    std::cout << "  " << std::left << std::setw(28) << what << std::right
+              << std::setw(10) << std::fixed << std::setprecision(3) << 1e-9 * (double)bytes / sec
+              << " GB/s    (" << bytes << " B, " << sec << " s)\n";
+}
+
+void RunSize(const Options& o, double target) {
+    const int nxy = std::max(1, (int)std::lround(std::sqrt(target / o.nz)));
+    const double hx = 0.5 * nxy * o.dxyNm * nm;
+    VoxelGrid grid;
+    grid.Configure(Vec3(-hx, -hx, -o.nz * o.dzNm * nm), Vec3(hx, hx, 0.0),
+                   o.dxyNm * nm, o.dxyNm * nm, o.dzNm * nm);
+    VoxelGrid eventGrid;
+    eventGrid.ConfigureEventAccumulators(grid);
+    const size_t nVox = (size_t)grid.Nx() * (size_t)grid.Ny() * (size_t)grid.Nz();
+
+    const Stream s = MakeStream(o, grid);
+    const double nSteps = (double)s.steps.size();
+    std::cout << "grid " << grid.Nx() << " x " << grid.Ny() << " x " << grid.Nz()
+              << " = " << nVox << " voxels, " << o.events << " events, "
+              << s.steps.size() << " steps, " << VoxelLayout::kName << " layout, "
+              << VoxelStorage::kName << " storage\n";
+
+    // ToIndex + Flatten alone
+    auto t0 = Clock::now();
+    size_t sink = 0;
+    for (const auto& st : s.steps) sink += grid.Flatten(grid.ToIndex(st.p));
+    Report("ToIndex", Seconds(t0), nSteps, "step");
+
+    // Event scoring: AddEdep buffers steps; binning, record fill and reset at end of event
+    std::vector<EventRecord> records(o.events);
+    double tAdd = 0.0, tReset = 0.0;
+    size_t touched = 0;
+    for (int e = 0; e < o.events; ++e) {
+        t0 = Clock::now();
+        for (size_t k = s.offsets[e]; k < s.offsets[e + 1]; ++k) eventGrid.AddEdep(s.steps[k].p, s.steps[k].edep);
+        tAdd += Seconds(t0);
+
+        t0 = Clock::now();
+        eventGrid.FillEventRecord(records[e]);
+        records[e].eventId = e;
+        eventGrid.ResetEventAccumulators();
+        tReset += Seconds(t0);
+        touched += records[e].Size();
+    }
+    const double nTouched = (double)std::max<size_t>(touched, 1);
+    Report("AddEdep", tAdd, nSteps, "step");
+    Report("Bin+FillRecord+ResetEvent", tReset, nTouched, "touched voxel");
+
+    // Vacancy stage
+    VacancyModel model;
+    model.GetParams().initConc_cm3 = o.vacConcCm3;
+    model.ConfigureFromGrid(grid);
+    t0 = Clock::now();
+    model.ResetAndInit(grid);
+    Report("ResetAndInit", Seconds(t0), (double)nVox, "voxel");
+    {
+        // The whole initial field, as the KMC and the Python views draw it
+        VacancyModel dense;
+        dense.GetParams().initConc_cm3 = o.vacConcCm3;
+        dense.ConfigureFromGrid(grid);
+        t0 = Clock::now();
+        sink += dense.DenseVacCount()[0];
+        Report("InitialField (dense)", Seconds(t0), (double)nVox, "voxel");
+    }
+
+    t0 = Clock::now();
+    for (const auto& rec : records) grid.AddEventToRun(rec);
+    Report("AddEventToRun", Seconds(t0), nTouched, "touched voxel");
+
+    t0 = Clock::now();
+    for (const auto& rec : records) model.ProcessEvent(rec);
+    Report("ProcessEvent", Seconds(t0), nTouched, "touched voxel");
+
+    // Face-neighbour loads around every touched voxel (the ProcessEvent probe)
+    t0 = Clock::now();
+    const auto& vac = model.VacCounts();
+    const VoxelLayout& layout = grid.Layout();
+    size_t probes = 0;
+    for (const auto& rec : records) {
+        for (size_t k = 0; k < rec.Size(); ++k) {
+            size_t nbr[6];
+            const int n = layout.Neighbors6(rec.flat[k], nbr);
+            for (int j = 0; j < n; ++j) sink += vac.Get(nbr[j]);
+            probes += (size_t)n;
+        }
+    }
+    Report("Neighbors6", Seconds(t0), (double)std::max<size_t>(probes, 1), "probe");
+
+    // Exports (written to 'dir' and removed again)
+    const std::string base = o.dir + "/hfo2bench";
+    std::vector<std::string> written;
+    auto timeExport = [&](const std::string& what, const std::vector<std::string>& files, auto&& fn) {
+        const auto t = Clock::now();
+        fn();
+        const double sec = Seconds(t);
+        size_t bytes = 0;
+        for (const auto& f : files) { bytes += FileBytes(f); written.push_back(f); }
+        ReportExport(what, sec, bytes);
+    };
+
+    timeExport("ExportEdepNpySparse", {base + "_idx.npy", base + "_edep_eV.npy"},
+               [&] { grid.ExportEdepNpySparse(base); });
+    timeExport("ExportVacancyNpySparse",
+               {base + "_sparse_idx.npy", base + "_sparse_vacCount.npy", base + "_sparse_Ebank_eV.npy"},
+               [&] { model.ExportVacancyNpySparse(base); });
+    timeExport("ExportSummaryCSV", {base + "_summary.csv"},
+               [&] { model.ExportSummaryCSV(base + "_summary.csv", o.events); });
+    if ((double)nVox <= o.exportMax) {
+        timeExport("ExportEdepNpy", {base + "_edep.npy"}, [&] { grid.ExportEdepNpy(base + "_edep.npy"); });
+        timeExport("ExportVacancyNpy", {base + "_vacCount.npy", base + "_Ebank_eV.npy"},
+                   [&] { model.ExportVacancyNpy(base); });
+        timeExport("ExportEdepCSV", {base + "_edep.csv"}, [&] { grid.ExportEdepCSV(base + "_edep.csv"); });
+        timeExport("ExportVacancyCSV", {base + "_vac.csv"},
+                   [&] { model.ExportVacancyCSV(base + "_vac.csv", grid); });
+    } else {
+        std::cout << "  dense exports skipped (voxels > exportMax)\n";
+    }
+    for (const auto& f : written) std::remove(f.c_str());
+
+    std::cout << "  memory: grid " << grid.MemoryBytes() + eventGrid.MemoryBytes()
+              << " B, model " << model.MemoryBytes() << " B, created " << model.TotalCreated()
+              << " (checksum " << (sink & 0xffff) << ")\n\n";
+}
+
+std::vector<double> ParseList(const std::string& val) {
+    std::vector<double> out;
+    std::stringstream ss(val);
+    std::string item;
+    while (std::getline(ss, item, ',')) out.push_back(std::stod(item));
+    return out;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto eq = arg.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Expected key=value, got '" << arg << "'\n";
+            return 1;
+        }
+        const std::string key = arg.substr(0, eq), val = arg.substr(eq + 1);
+        if      (key == "sizes")       o.sizes = ParseList(val);
+        else if (key == "nz")          o.nz = std::stoi(val);
+        else if (key == "dxyNm")       o.dxyNm = std::stod(val);
+        else if (key == "dzNm")        o.dzNm = std::stod(val);
+        else if (key == "events")      o.events = std::stoi(val);
+        else if (key == "tracks")      o.tracks = std::stoi(val);
+        else if (key == "spotNm")      o.spotNm = std::stod(val);
+        else if (key == "stepNm")      o.stepNm = std::stod(val);
+        else if (key == "edepMean_eV") o.edepMean_eV = std::stod(val);
+        else if (key == "deltaProb")   o.deltaProb = std::stod(val);
+        else if (key == "vacConcCm3")  o.vacConcCm3 = std::stod(val);
+        else if (key == "exportMax")   o.exportMax = std::stod(val);
+        else if (key == "dir")         o.dir = val;
+        else if (key == "seed")        o.seed = std::stoull(val);
+        else {
+            std::cerr << "Unknown option '" << key << "'\n";
+            return 1;
+        }
+    }
+
+    try {
+        for (double n : o.sizes) RunSize(o, n);
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -8,8 +8,9 @@ public:
     explicit ActionInitialization(DetectorConstruction* det);
     ~ActionInitialization() override = default;
 
+    void BuildForMaster() const override;
     void Build() const override;
 
 private:
     DetectorConstruction* fDet = nullptr;
-};
\ No newline at end of file
+};
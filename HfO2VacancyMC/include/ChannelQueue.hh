@@ -0,0 +1,194 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "IndexedMinHeap.hh"
+
+// Next-reaction queue of the KMC engines over voxel ids 0..n-1.
+//
+// A voxel holding vacancies is a channel of its own (tracked). An empty voxel
+// can only generate, at a rate bounded by its block's rEmpty, so the empty
+// voxels of each block of kBlock ids are pooled into one channel of rate
+// rEmpty * (pooled voxels in the block); when it fires, the engine picks the
+// voxel uniformly within the block (Pick) and, if the voxel's own rate is
+// below rEmpty, accepts it with probability rate / rEmpty (thinning). The
+// heap thus holds one entry per block plus one per tracked voxel (slots are
+// recycled), not one per voxel.
+//
+// Channel numbers: 0..Blocks()-1 are the pools, the rest tracked slots.
+// Rates change by rescaling the pending draw (Gibson & Bruck).
+class ChannelQueue {
+public:
+    static constexpr size_t kBlock = 4096;   // = VacancyModel::kInitChunk
+    using Rng = std::mt19937_64;
+
+    // Start a rebuild over n ids; ids never added are padding (never fire).
+    void Begin(size_t n, double rEmpty) {
+        fN = n;
+        fPooled.assign((n + kBlock - 1) / kBlock, 0);
+        fREmpty.assign(fPooled.size(), rEmpty);
+        fRate.assign(fPooled.size(), 0.0);
+        fVoxel.clear();
+        fSlot.clear();
+        fFree.clear();
+    }
+    void AddPooled(size_t id) { ++fPooled[id / kBlock]; }
+    void AddTracked(size_t id, double rate) {
+        fSlot.emplace(id, fVoxel.size());
+        fVoxel.push_back(id);
+        fRate.push_back(rate);
+    }
+    // Draw every first firing time, in channel order, and heapify.
+    void Build(Rng& rng) {
+        for (size_t b = 0; b < fPooled.size(); ++b) fRate[b] = PoolRate(b);
+        std::vector<double> next(fRate.size());
+        for (size_t ch = 0; ch < next.size(); ++ch) {
+            next[ch] = fRate[ch] > 0.0 ? Exponential(rng, fRate[ch]) : IndexedMinHeap::kNever;
+        }
+        fQueue.Build(std::move(next));
+    }
+
+    bool Empty() const { return fQueue.Empty(); }
+    size_t Top() const { return fQueue.Top(); }
+    double TopKey() const { return fQueue.TopKey(); }
+    double Key(size_t ch) const { return fQueue.Key(ch); }
+    double Rate(size_t ch) const { return fRate[ch]; }
+
+    size_t Blocks() const { return fPooled.size(); }
+    bool IsPool(size_t ch) const { return ch < fPooled.size(); }
+    size_t Voxel(size_t ch) const { return fVoxel[ch - fPooled.size()]; }
+    size_t Tracked() const { return fSlot.size(); }
+
+    // Voxel id is empty: pool it, releasing its tracked channel if it had one.
+    void Pool(size_t id, double now, Rng& rng) {
+        const auto it = fSlot.find(id);
+        if (it == fSlot.end()) return;
+        const size_t ch = fPooled.size() + it->second;
+        fRate[ch] = 0.0;
+        fQueue.Update(ch, IndexedMinHeap::kNever);
+        fFree.push_back(it->second);
+        fSlot.erase(it);
+
+        const size_t b = id / kBlock;
+        ++fPooled[b];
+        Rescale(b, PoolRate(b), now, rng);
+    }
+
+    // Voxel id holds vacancies: track it at the given rate.
+    void Track(size_t id, double rate, double now, Rng& rng) {
+        const auto it = fSlot.find(id);
+        if (it != fSlot.end()) {
+            Rescale(fPooled.size() + it->second, rate, now, rng);
+            return;
+        }
+        const size_t b = id / kBlock;
+        --fPooled[b];
+        Rescale(b, PoolRate(b), now, rng);
+
+        const double t = rate > 0.0 ? now + Exponential(rng, rate) : IndexedMinHeap::kNever;
+        size_t slot;
+        if (!fFree.empty()) {
+            slot = fFree.back();
+            fFree.pop_back();
+            fVoxel[slot] = id;
+            fRate[fPooled.size() + slot] = rate;
+            fQueue.Update(fPooled.size() + slot, t);
+        } else {
+            slot = fVoxel.size();
+            fVoxel.push_back(id);
+            fRate.push_back(rate);
+            fQueue.Push(t);
+        }
+        fSlot.emplace(id, slot);
+    }
+
+    // The channel just fired: fresh time at the given rate.
+    void Redraw(size_t ch, double rate, double now, Rng& rng) {
+        fRate[ch] = rate;
+        fQueue.Update(ch, rate > 0.0 ? now + Exponential(rng, rate) : IndexedMinHeap::kNever);
+    }
+    double PoolRate(size_t block) const { return fREmpty[block] * fPooled[block]; }
+    double EmptyRate(size_t block) const { return fREmpty[block]; }
+    // New per-voxel bound for the empty voxels of a block
+    void SetEmptyRate(size_t block, double rEmpty, double now, Rng& rng) {
+        fREmpty[block] = rEmpty;
+        Rescale(block, PoolRate(block), now, rng);
+    }
+
+    // Visit the tracked voxel ids (f must not add or remove channels)
+    template <class F>
+    void ForEachTracked(F&& f) const {
+        for (const auto& kv : fSlot) f(kv.first);
+    }
+
+    // Uniformly chosen pooled id of a block; pooled(id) must say whether id
+    // is in the pool (empty and not padding).
+    template <class F>
+    size_t Pick(size_t block, F&& pooled, Rng& rng) const {
+        const size_t base = block * kBlock;
+        const size_t count = std::min(kBlock, fN - base);
+        const uint32_t k = fPooled[block];
+        if ((size_t)k * 4 >= count) {
+            // mostly empty: rejection over the block
+            for (;;) {
+                const size_t id = base + std::min(count - 1, (size_t)(Uniform(rng) * count));
+                if (pooled(id)) return id;
+            }
+        }
+        uint32_t j = std::min(k - 1, (uint32_t)(Uniform(rng) * k));
+        for (size_t id = base;; ++id) {
+            if (pooled(id) && j-- == 0) return id;
+        }
+    }
+
+    double TotalRate() const {
+        double sum = 0.0;
+        for (double r : fRate) sum += r;
+        return sum;
+    }
+
+    size_t MemoryBytes() const {
+        return fQueue.MemoryBytes() + fRate.size() * sizeof(double)
+             + fPooled.size() * (sizeof(uint32_t) + sizeof(double))
+             + (fVoxel.size() + fFree.size()) * sizeof(size_t)
+             + fSlot.size() * (sizeof(size_t) * 4);   // node and bucket estimate
+    }
+
+    static double Uniform(Rng& rng) { return std::generate_canonical<double, 53>(rng); }
+    static double Exponential(Rng& rng, double rate) {
+        // 1 - U in (0,1], so the log is finite
+        return -std::log(1.0 - Uniform(rng)) / rate;
+    }
+
+private:
+    void Rescale(size_t ch, double rNew, double now, Rng& rng) {
+        const double rOld = fRate[ch];
+        if (rNew == rOld) return;
+        fRate[ch] = rNew;
+
+        // Reuse the pending draw rescaled to the new rate, so channels that
+        // did not fire need no new random number.
+        const double tOld = fQueue.Key(ch);
+        double t = IndexedMinHeap::kNever;
+        if (rNew > 0.0) {
+            t = (rOld > 0.0 && tOld != IndexedMinHeap::kNever)
+                    ? now + (rOld / rNew) * (tOld - now)
+                    : now + Exponential(rng, rNew);
+        }
+        fQueue.Update(ch, t);
+    }
+
+    size_t fN{0};
+    std::vector<double> fREmpty;                 // by block
+    std::vector<uint32_t> fPooled;               // by block
+    std::vector<double> fRate;                   // by channel
+    std::vector<size_t> fVoxel;                  // slot -> id
+    std::unordered_map<size_t, size_t> fSlot;    // tracked id -> slot
+    std::vector<size_t> fFree;                   // released slots
+    IndexedMinHeap fQueue;
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+class VoxelGrid;
+class VacancyModel;
+
+// Binary checkpoint of the irradiation state (little-endian, native layout):
+//   magic[8] "HFO2CKP1", uint32 version, uint32 layout (VoxelLayout::kId),
+//   uint32 storage (VoxelStorage::kId, version >= 3),
+//   int32 nx, ny, nz, double dx_nm, dy_nm, dz_nm, double min_nm[3],
+//   int64 eventsDone, uint64 eventSeed,
+//   VoxelGrid run accumulators, VacancyModel state (allocated chunks only;
+//   bank clock and stamps from version 4)
+// Chunks are in storage order and raw storage types, so only a build with the
+// same layout and storage reads it. Files before version 5 restart only runs
+// without an initial vacancy field (the generator of that field changed).
+//
+// Geant4's engine state is not stored: with a non-zero eventSeed every event
+// is reseeded from (eventSeed, global event index), so a continued run needs
+// only the event counter to draw the same histories as an uninterrupted one.
+class Checkpoint {
+public:
+    struct Info {
+        long long eventsDone{0};   // events committed before the checkpoint
+        uint64_t eventSeed{0};
+    };
+
+    // Writes <path>.tmp and renames it over <path>, so an interrupted write
+    // never replaces a good checkpoint. Returns false on I/O errors.
+    static bool Write(const std::string& path, const VoxelGrid& grid, const VacancyModel& vac,
+                      const Info& info);
+
+    // The same in two steps: Snapshot copies the state (allocated chunks and
+    // counters) into memory, WriteBytes stores it later through <path>.tmp.
+    // Lets the committer cut at an exact event and write outside its lock.
+    static std::string Snapshot(const VoxelGrid& grid, const VacancyModel& vac, const Info& info);
+    static bool WriteBytes(const std::string& path, const std::string& bytes);
+
+    // Restores into a grid of the same shape and a model just reset with
+    // ResetAndInit(); throws std::runtime_error on a bad or mismatching file.
+    static Info Read(const std::string& path, VoxelGrid& grid, VacancyModel& vac);
+};
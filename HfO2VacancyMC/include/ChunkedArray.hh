@@ -0,0 +1,209 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+// Sparse 1D array over the voxel flat index, split into fixed-size chunks that
+// are allocated on first write. Unallocated chunks read as a uniform
+// background value or, if an initializer is set, as the values the
+// initializer would produce (generated on demand, so a lazily initialized
+// field costs memory only where it is actually modified or probed).
+//
+// Memory therefore follows the touched footprint, not the grid volume.
+// Densify() switches to one contiguous slab (e.g. for zero-copy NumPy views);
+// the slab then stays in place across Reset(). Both produce the chunks of the
+// slab in parallel (OpenMP, when enabled).
+// Not thread-safe: const reads of lazily initialized chunks go through a
+// one-chunk scratch cache.
+template <class T, unsigned Log2Chunk = 12>
+class ChunkedArray {
+public:
+    static constexpr size_t kChunk = size_t(1) << Log2Chunk;
+    static constexpr size_t kMask = kChunk - 1;
+
+    // Fills data[0..count) for chunk index 'chunk'. Must be deterministic and
+    // safe to call for different chunks concurrently.
+    using ChunkInit = std::function<void(size_t chunk, T* data, size_t count)>;
+
+    void Configure(size_t n, T background, ChunkInit init = nullptr) {
+        fN = n;
+        fBackground = background;
+        fInit = std::move(init);
+        fChunks.clear();
+        fChunks.resize((n + kMask) >> Log2Chunk);
+        fSlab.reset();
+        fAllocated = 0;
+        fScratchChunk = SIZE_MAX;
+    }
+
+    // Drop every chunk: the array reads as background/initializer again.
+    // In dense mode the slab is refilled in place instead.
+    void Reset() {
+        fScratchChunk = SIZE_MAX;
+        if (fSlab) {
+            #pragma omp parallel for schedule(dynamic, 16)
+            for (size_t c = 0; c < fChunks.size(); ++c) Produce(c, fChunks[c].get());
+            return;
+        }
+        for (auto& c : fChunks) c.reset();
+        fAllocated = 0;
+    }
+
+    void SetInitializer(ChunkInit init) {
+        fInit = std::move(init);
+        Reset();
+    }
+
+    // Materialize every chunk into one contiguous slab laid out in flat order;
+    // returns its base pointer (valid until the next Configure()).
+    T* Densify() {
+        if (fSlab) return fSlab.get();
+
+        T* slab = new T[fChunks.size() * kChunk];
+        #pragma omp parallel for schedule(dynamic, 16)
+        for (size_t c = 0; c < fChunks.size(); ++c) {
+            T* dst = slab + c * kChunk;
+            if (fChunks[c]) std::copy(fChunks[c].get(), fChunks[c].get() + kChunk, dst);
+            else if (fScratchChunk == c) std::copy(fScratch.get(), fScratch.get() + kChunk, dst);
+            else Produce(c, dst);
+            fChunks[c] = ChunkPtr(dst, ChunkDeleter{false});
+        }
+        fSlab.reset(slab);
+        fAllocated = fChunks.size();
+        fScratchChunk = SIZE_MAX;
+        return slab;
+    }
+
+    bool IsDense() const { return (bool)fSlab; }
+
+    size_t Size() const { return fN; }
+    size_t NumChunks() const { return fChunks.size(); }
+    size_t AllocatedChunks() const { return fAllocated; }
+    size_t MemoryBytes() const {
+        return fAllocated * kChunk * sizeof(T) + fChunks.size() * sizeof(fChunks[0]);
+    }
+
+    bool IsAllocated(size_t chunk) const { return (bool)fChunks[chunk]; }
+
+    T Get(size_t i) const {
+        const size_t c = i >> Log2Chunk;
+        if (fChunks[c]) return fChunks[c][i & kMask];
+        if (!fInit) return fBackground;
+        return ScratchChunk(c)[i & kMask];
+    }
+
+    // Writable reference; allocates (and initializes) the chunk on first use.
+    T& Ref(size_t i) {
+        const size_t c = i >> Log2Chunk;
+        if (!fChunks[c]) Allocate(c);
+        return fChunks[c][i & kMask];
+    }
+
+    T& operator[](size_t i) { return Ref(i); }
+    T operator[](size_t i) const { return Get(i); }
+
+    // Visit every chunk in order as (chunk, data, count); absent chunks are
+    // produced into scratch without being kept.
+    template <class F>
+    void ForEachChunk(F&& f) const {
+        for (size_t c = 0; c < fChunks.size(); ++c) {
+            const T* data = fChunks[c] ? fChunks[c].get() : ScratchChunk(c);
+            f(c, data, ChunkCount(c));
+        }
+    }
+
+    // Visit allocated chunks only (everything else is background/initial).
+    template <class F>
+    void ForEachAllocated(F&& f) const {
+        for (size_t c = 0; c < fChunks.size(); ++c) {
+            if (fChunks[c]) f(c, fChunks[c].get(), ChunkCount(c));
+        }
+    }
+
+    // Binary dump of the allocated chunks: uint64 count, then per chunk uint64
+    // index and kChunk raw values. Everything else is background/initializer,
+    // so Load() must follow a Configure()/Reset() with the same initializer.
+    void Save(std::ostream& out) const {
+        uint64_t count = 0;
+        for (const auto& c : fChunks) count += (bool)c;
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (size_t c = 0; c < fChunks.size(); ++c) {
+            if (!fChunks[c]) continue;
+            const uint64_t index = c;
+            out.write(reinterpret_cast<const char*>(&index), sizeof(index));
+            out.write(reinterpret_cast<const char*>(fChunks[c].get()), (std::streamsize)(kChunk * sizeof(T)));
+        }
+    }
+
+    void Load(std::istream& in) {
+        uint64_t count = 0;
+        if (!in.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+            throw std::runtime_error("ChunkedArray: truncated chunk table");
+        }
+        for (uint64_t k = 0; k < count; ++k) {
+            uint64_t index = 0;
+            if (!in.read(reinterpret_cast<char*>(&index), sizeof(index)) || index >= fChunks.size()) {
+                throw std::runtime_error("ChunkedArray: bad chunk index");
+            }
+            T* data = &Ref(index << Log2Chunk);
+            if (!in.read(reinterpret_cast<char*>(data), (std::streamsize)(kChunk * sizeof(T)))) {
+                throw std::runtime_error("ChunkedArray: truncated chunk");
+            }
+        }
+    }
+
+private:
+    // Chunks inside the dense slab are not owned individually
+    struct ChunkDeleter {
+        bool owned = true;
+        void operator()(T* p) const { if (owned) delete[] p; }
+    };
+    using ChunkPtr = std::unique_ptr<T[], ChunkDeleter>;
+
+    size_t ChunkCount(size_t c) const {
+        return std::min(kChunk, fN - (c << Log2Chunk));
+    }
+
+    void Produce(size_t c, T* data) const {
+        const size_t count = ChunkCount(c);
+        if (fInit) fInit(c, data, count);
+        else std::fill(data, data + count, fBackground);
+        std::fill(data + count, data + kChunk, fBackground);
+    }
+
+    void Allocate(size_t c) {
+        fChunks[c] = ChunkPtr(new T[kChunk], ChunkDeleter{true});
+        if (fScratchChunk == c) {
+            std::copy(fScratch.get(), fScratch.get() + kChunk, fChunks[c].get());
+            fScratchChunk = SIZE_MAX;
+        } else {
+            Produce(c, fChunks[c].get());
+        }
+        ++fAllocated;
+    }
+
+    const T* ScratchChunk(size_t c) const {
+        if (!fScratch) fScratch.reset(new T[kChunk]);
+        if (fScratchChunk != c) {
+            Produce(c, fScratch.get());
+            fScratchChunk = c;
+        }
+        return fScratch.get();
+    }
+
+    size_t fN{0};
+    T fBackground{};
+    ChunkInit fInit;
+    std::vector<ChunkPtr> fChunks;
+    std::unique_ptr<T[]> fSlab;
+    size_t fAllocated{0};
+
+    mutable std::unique_ptr<T[]> fScratch;
+    mutable size_t fScratchChunk{SIZE_MAX};
+};
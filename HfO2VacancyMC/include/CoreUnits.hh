@@ -0,0 +1,43 @@
+#pragma once
+#include <utility>
+
+// Units and points for the Geant4-free core (HfO2Core: voxel grid, vacancy
+// stage, kinetics, solvers). Values follow the Geant4/CLHEP internal system
+// (mm = 1, MeV = 1), so lengths and energies pass between the core and the
+// Geant4 application unchanged. Kept in a namespace so it never clashes with
+// G4SystemOfUnits in translation units that include both.
+namespace hfo2units {
+constexpr double mm  = 1.0;
+constexpr double nm  = 1e-6 * mm;
+constexpr double um  = 1e-3 * mm;
+constexpr double cm  = 10.0 * mm;
+constexpr double MeV = 1.0;
+constexpr double keV = 1e-3 * MeV;
+constexpr double eV  = 1e-6 * MeV;
+}
+
+// Minimal 3-vector for the core interface. Anything with x(), y(), z()
+// (G4ThreeVector in particular) converts implicitly, so Geant4 callers pass
+// their points unchanged.
+class Vec3 {
+public:
+    constexpr Vec3() = default;
+    constexpr Vec3(double x, double y, double z) : fX(x), fY(y), fZ(z) {}
+    template <class V, class = decltype(std::declval<const V&>().x())>
+    Vec3(const V& v) : fX(v.x()), fY(v.y()), fZ(v.z()) {}
+
+    constexpr double x() const { return fX; }
+    constexpr double y() const { return fY; }
+    constexpr double z() const { return fZ; }
+
+    friend constexpr Vec3 operator+(const Vec3& a, const Vec3& b) { return {a.fX + b.fX, a.fY + b.fY, a.fZ + b.fZ}; }
+    friend constexpr Vec3 operator-(const Vec3& a, const Vec3& b) { return {a.fX - b.fX, a.fY - b.fY, a.fZ - b.fZ}; }
+    friend constexpr Vec3 operator*(double s, const Vec3& a) { return {s * a.fX, s * a.fY, s * a.fZ}; }
+    friend constexpr Vec3 operator*(const Vec3& a, double s) { return {s * a.fX, s * a.fY, s * a.fZ}; }
+    friend constexpr bool operator==(const Vec3& a, const Vec3& b) {
+        return a.fX == b.fX && a.fY == b.fY && a.fZ == b.fZ;
+    }
+
+private:
+    double fX{0}, fY{0}, fZ{0};
+};
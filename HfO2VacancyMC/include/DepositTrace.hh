@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "EventRecord.hh"
+
+// Binary per-event deposition trace (little-endian, native layout):
+//   header: magic[8] "HFO2TRC1", uint32 version, uint32 layout (VoxelLayout::kId),
+//           int32 nx, ny, nz, double dx_nm, dy_nm, dz_nm, double min_nm[3]
+//   event:  int64 eventId, uint32 n, uint64 flat[n], double edep_eV[n]
+// The flat index follows VoxelGrid::Flatten, so a trace is read back only by
+// a build with the same storage layout (version 1 traces: row-major, no
+// layout field). Replaying a trace through
+// VacancyModel::ProcessEvent reproduces the vacancy stage without transport.
+struct DepositTraceHeader {
+    int32_t nx{0}, ny{0}, nz{0};
+    double dx_nm{0}, dy_nm{0}, dz_nm{0};
+    double min_nm[3]{0, 0, 0};
+};
+
+class DepositTraceWriter {
+public:
+    DepositTraceWriter() = default;
+    ~DepositTraceWriter() { Close(); }
+
+    bool Open(const std::string& path, const DepositTraceHeader& h);
+    void Write(const EventRecord& rec);
+    void Close();
+
+    bool IsOpen() const { return fOut.is_open(); }
+    long long EventsWritten() const { return fEvents; }
+
+private:
+    std::ofstream fOut;
+    std::vector<char> fBuffer;
+    long long fEvents{0};
+};
+
+class DepositTraceReader {
+public:
+    bool Open(const std::string& path);   // throws on a bad header
+    bool Next(EventRecord& rec);          // false at end of trace
+
+    const DepositTraceHeader& Header() const { return fHeader; }
+
+private:
+    std::ifstream fIn;
+    std::vector<char> fBuffer;
+    DepositTraceHeader fHeader;
+};
@@ -5,6 +5,12 @@
 #include "G4Region.hh"
 #include "VoxelGrid.hh"
 #include "VacancyModel.hh"
+#include "EventCommitter.hh"
+#include "VacancyKMC.hh"
+#include "PotentialSolver.hh"
+#include "LeakageCurrent.hh"
+#include "PerfMonitor.hh"
+#include "SubstrateKiller.hh"
 
 class DetectorConstruction : public G4VUserDetectorConstruction {
 public:
@@ -24,6 +30,29 @@ public:
     VacancyModel& GetVacancyModel() { return fVacancy; }
     const VacancyModel& GetVacancyModel() const { return fVacancy; }
 
+    // Event-ordered commit stage shared by all worker threads
+    EventCommitter& GetCommitter() { return fCommitter; }
+
+    // Vacancy kinetics (generation/migration/recombination) on fVacancy's state
+    VacancyKMC& GetKMC() { return fKMC; }
+
+    // Electrostatic potential with vacancy-dependent permittivity
+    PotentialSolver& GetPotentialSolver() { return fPotential; }
+
+    // Trap-assisted tunnelling current through the vacancy traps
+    LeakageCurrent& GetLeakageCurrent() { return fLeakage; }
+
+    // Hot-path instrumentation (/perf/)
+    PerfMonitor& GetPerfMonitor() { return fPerf; }
+
+    // Range-based killing / roulette of electrons in the Si substrate
+    SubstrateKiller& GetSubstrateKiller() { return fSubstrate; }
+    const G4VPhysicalVolume* GetSiPV() const { return fPhysSi; }
+    const G4VPhysicalVolume* GetHfO2PV() const { return fPhysHfO2; }
+
+    // /det/splitSteps: deposit along the step path rather than at its midpoint
+    bool GetSplitSteps() const { return fSplitSteps; }
+
     void SetInitVacConcCm3(double c) { fVacancy.GetParams().initConc_cm3 = c; }
     void SetInitVacSeed(uint64_t s)  { fVacancy.GetParams().initSeed = s; }
     void SetHfO2Density_g_cm3(double rho) { fVacancy.GetParams().rho_g_cm3 = rho; }
@@ -43,18 +72,38 @@ private:
     double fVoxelDyNm = 50.0;
     double fVoxelDzNm = 1.0;
 
+    // Scoring of HfO2 steps
+    bool fSplitSteps = false;           // path-length split over voxels, else midpoint
+    double fHfO2MaxStepNm = 0.0;        // 0 = no step limit
+
     G4GenericMessenger* fMessenger = nullptr;
+    G4GenericMessenger* fKmcMessenger = nullptr;
+    G4GenericMessenger* fFieldMessenger = nullptr;
+    G4GenericMessenger* fTatMessenger = nullptr;
+    G4GenericMessenger* fPerfMessenger = nullptr;
+    G4GenericMessenger* fSubstrateMessenger = nullptr;
 
     // Pointers to volumes
     G4LogicalVolume* fLogicWorld = nullptr;
     G4LogicalVolume* fLogicSi = nullptr;
     G4LogicalVolume* fLogicHfO2 = nullptr;
+    G4VPhysicalVolume* fPhysHfO2 = nullptr;
+    G4VPhysicalVolume* fPhysSi = nullptr;
 
-    // Region for HfO2 (cuts)
+    // Region for HfO2 (cuts, low-energy EM models) and for the Si substrate
     G4Region* fHfO2Region = nullptr;
+    G4Region* fSiRegion = nullptr;
 
     // Voxel grid in HfO2 volume
     VoxelGrid fGrid;
 
     VacancyModel fVacancy;
+
+    VacancyKMC fKMC;
+    PotentialSolver fPotential;
+    LeakageCurrent fLeakage;
+    PerfMonitor fPerf;
+    SubstrateKiller fSubstrate;
+
+    EventCommitter fCommitter{fGrid, fVacancy};
 };
@@ -0,0 +1,36 @@
+#pragma once
+#include "G4GenericMessenger.hh"
+#include "G4String.hh"
+
+class G4RunManager;
+
+// Breakdown-statistics ensembles from one initialized kernel (/ensemble/).
+//
+// /ensemble/run builds the physics tables once (beamOn 0), then forks one
+// child process per realization; children share the tables and geometry
+// copy-on-write with the parent. Realization i runs in <dir>/r<i> with its
+// own /det/vacSeed and /ckpt/eventSeed and writes the usual outputs there.
+// The parent keeps at most 'jobs' children running and finally merges every
+// hfO2_vacancy_summary.csv into one report (EnsembleStats), plus a Weibull fit
+// of the breakdown event when /det/trackPercolation is on.
+//
+// fork() only clones the calling thread, so this needs the serial run
+// manager (G4RUN_MANAGER_TYPE=Serial); parallelism comes from the processes.
+class EnsembleRunner {
+public:
+    explicit EnsembleRunner(G4RunManager* runManager);
+
+    void Run();
+
+private:
+    G4RunManager* fRunManager = nullptr;
+
+    G4int fRealizations = 100;
+    G4int fEvents = 100000;         // beamOn per realization
+    G4int fJobs = 0;                // concurrent children; 0 = hardware threads
+    G4int fBaseSeed = 1;
+    G4String fDir = "ensemble";
+    G4String fReport = "hfO2_ensemble_summary.csv";
+
+    G4GenericMessenger* fMessenger = nullptr;
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Per-key statistics over an ensemble of realizations (one value per key and
+// realization, e.g. the rows of hfO2_vacancy_summary.csv). Mean and variance
+// are accumulated online (Welford); the values are kept for quantiles, which
+// is cheap at ensemble sizes of a few thousand.
+class EnsembleStats {
+public:
+    void Add(const std::string& key, double v) {
+        auto it = fSeries.find(key);
+        if (it == fSeries.end()) {
+            it = fSeries.emplace(key, Series{}).first;
+            fOrder.push_back(key);
+        }
+        Series& s = it->second;
+        ++s.n;
+        const double d = v - s.mean;
+        s.mean += d / (double)s.n;
+        s.m2 += d * (v - s.mean);
+        s.values.push_back(v);
+    }
+
+    // Adds every numeric key,value row of a summary CSV; returns rows read.
+    size_t AddSummaryCSV(const std::string& path) {
+        std::ifstream in(path);
+        std::string line;
+        size_t rows = 0;
+        while (std::getline(in, line)) {
+            const auto comma = line.find(',');
+            if (comma == std::string::npos) continue;
+            const std::string val = line.substr(comma + 1);
+            char* end = nullptr;
+            const double v = std::strtod(val.c_str(), &end);
+            if (end == val.c_str()) continue;   // header or non-numeric
+            Add(line.substr(0, comma), v);
+            ++rows;
+        }
+        return rows;
+    }
+
+    long long Count(const std::string& key) const {
+        auto it = fSeries.find(key);
+        return it == fSeries.end() ? 0 : it->second.n;
+    }
+    double Mean(const std::string& key) const {
+        auto it = fSeries.find(key);
+        return it == fSeries.end() ? 0.0 : it->second.mean;
+    }
+    double StdDev(const std::string& key) const {
+        auto it = fSeries.find(key);
+        return (it == fSeries.end() || it->second.n < 2) ? 0.0
+               : std::sqrt(it->second.m2 / (double)(it->second.n - 1));
+    }
+    // Linear-interpolated sample quantile, q in [0,1]
+    double Quantile(const std::string& key, double q) const {
+        auto it = fSeries.find(key);
+        if (it == fSeries.end() || it->second.values.empty()) return 0.0;
+        std::vector<double> v = it->second.values;
+        std::sort(v.begin(), v.end());
+        const double pos = q * (double)(v.size() - 1);
+        const size_t lo = (size_t)std::floor(pos);
+        const size_t hi = std::min(v.size() - 1, lo + 1);
+        return v[lo] + (pos - (double)lo) * (v[hi] - v[lo]);
+    }
+    const std::vector<double>& Values(const std::string& key) const {
+        static const std::vector<double> kEmpty;
+        auto it = fSeries.find(key);
+        return it == fSeries.end() ? kEmpty : it->second.values;
+    }
+
+    // key,n,mean,std,min,p05,p50,p95,max in first-seen key order
+    void WriteCSV(std::ostream& out) const {
+        out << "key,n,mean,std,min,p05,p50,p95,max\n";
+        for (const auto& key : fOrder) {
+            out << key << "," << Count(key) << "," << Mean(key) << "," << StdDev(key) << ","
+                << Quantile(key, 0.0) << "," << Quantile(key, 0.05) << "," << Quantile(key, 0.5) << ","
+                << Quantile(key, 0.95) << "," << Quantile(key, 1.0) << "\n";
+        }
+    }
+
+    // Two-parameter Weibull fit, F(t) = 1 - exp(-(t/scale)^shape), by least
+    // squares in Weibull-plot coordinates with Bernard median ranks over the
+    // 'total' realizations; 'times' are the failed ones (the rest are right-
+    // censored at the end of the run). Returns false with fewer than 2 failures.
+    static bool WeibullFit(std::vector<double> times, size_t total, double& shape, double& scale) {
+        times.erase(std::remove_if(times.begin(), times.end(), [](double t) { return !(t > 0.0); }),
+                    times.end());
+        if (times.size() < 2 || total < times.size()) return false;
+        std::sort(times.begin(), times.end());
+
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        const double n = (double)times.size();
+        for (size_t i = 0; i < times.size(); ++i) {
+            const double F = ((double)i + 0.7) / ((double)total + 0.4);
+            const double x = std::log(times[i]);
+            const double y = std::log(-std::log(1.0 - F));
+            sx += x; sy += y; sxx += x * x; sxy += x * y;
+        }
+        const double den = n * sxx - sx * sx;
+        if (den == 0.0) return false;
+        shape = (n * sxy - sx * sy) / den;
+        const double intercept = (sy - shape * sx) / n;
+        scale = std::exp(-intercept / shape);
+        return true;
+    }
+
+private:
+    struct Series {
+        long long n{0};
+        double mean{0}, m2{0};
+        std::vector<double> values;
+    };
+
+    std::map<std::string, Series> fSeries;
+    std::vector<std::string> fOrder;
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sparse per-event sum over voxel flat indices: an open-addressing table
+// (linear probing, Fibonacci hashing) of slots pointing into key/value
+// vectors kept in first-touch order. Memory and Clear() are O(touched voxels),
+// independent of the grid size.
+class EventAccumulator {
+public:
+    EventAccumulator() { Rehash(64); }
+
+    void Add(size_t key, double v) {
+        size_t s = Hash(key);
+        while (true) {
+            const int32_t e = fSlot[s];
+            if (e < 0) break;
+            if (fKeys[(size_t)e] == key) {
+                fValues[(size_t)e] += v;
+                return;
+            }
+            s = (s + 1) & fMask;
+        }
+        fSlot[s] = (int32_t)fKeys.size();
+        fSlotOf.push_back((uint32_t)s);
+        fKeys.push_back(key);
+        fValues.push_back(v);
+        if (2 * fKeys.size() > fSlot.size()) Rehash(2 * fSlot.size());
+    }
+
+    void Clear() {
+        for (uint32_t s : fSlotOf) fSlot[s] = -1;
+        fSlotOf.clear();
+        fKeys.clear();
+        fValues.clear();
+    }
+
+    size_t Size() const { return fKeys.size(); }
+    const std::vector<size_t>& Keys() const { return fKeys; }
+    const std::vector<double>& Values() const { return fValues; }
+
+    size_t MemoryBytes() const {
+        return fSlot.capacity() * sizeof(int32_t) + fSlotOf.capacity() * sizeof(uint32_t) +
+               fKeys.capacity() * sizeof(size_t) + fValues.capacity() * sizeof(double);
+    }
+
+private:
+    size_t Hash(size_t key) const {
+        return (size_t)(((uint64_t)key * 0x9E3779B97F4A7C15ull) >> fShift) & fMask;
+    }
+
+    void Rehash(size_t slots) {
+        int shift = 64;
+        for (size_t n = slots; n > 1; n >>= 1) --shift;
+        fShift = shift;
+        fMask = slots - 1;
+        fSlot.assign(slots, -1);
+        for (size_t e = 0; e < fKeys.size(); ++e) {
+            size_t s = Hash(fKeys[e]);
+            while (fSlot[s] >= 0) s = (s + 1) & fMask;
+            fSlot[s] = (int32_t)e;
+            fSlotOf[e] = (uint32_t)s;
+        }
+    }
+
+    std::vector<int32_t> fSlot;      // -1 empty, else index into fKeys
+    std::vector<uint32_t> fSlotOf;   // slot of each key, for Clear()
+    std::vector<size_t> fKeys;
+    std::vector<double> fValues;
+    size_t fMask{0};
+    int fShift{64};
+};
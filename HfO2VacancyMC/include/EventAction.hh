@@ -1,5 +1,8 @@
 #pragma once
 #include "G4UserEventAction.hh"
+#include "VoxelGrid.hh"
+#include "EventRecord.hh"
+#include "PerfMonitor.hh"
 
 class DetectorConstruction;
 
@@ -11,6 +14,16 @@ public:
     void BeginOfEventAction(const G4Event*) override;
     void EndOfEventAction(const G4Event*) override;
 
+    // Thread-local event accumulators (one EventAction per worker)
+    VoxelGrid& GetEventGrid() { return fEventGrid; }
+
+    // Thread-local /perf/ counters of the current event
+    PerfMonitor::EventSample& GetPerfSample() { return fPerfSample; }
+
 private:
     DetectorConstruction* fDet = nullptr;
+
+    VoxelGrid fEventGrid;
+    EventRecord fRecord;
+    PerfMonitor::EventSample fPerfSample;
 };
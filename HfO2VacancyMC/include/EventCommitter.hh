@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "EventRecord.hh"
+
+class VoxelGrid;
+class VacancyModel;
+class DepositTraceWriter;
+class VacancyKMC;
+class PotentialSolver;
+class PerfMonitor;
+
+// Serializes per-event deposits coming from any number of worker threads
+// into the shared run grid and vacancy model, strictly in event-ID order.
+// Out-of-order events are parked until the gap before them is filled, so the
+// committed state does not depend on the thread count or scheduling.
+class EventCommitter {
+public:
+    EventCommitter(VoxelGrid& runGrid, VacancyModel& vacancy);
+
+    void Reset();                    // start of run (master)
+    void Commit(EventRecord&& rec);  // end of event (any thread)
+    void Flush();                    // end of run: commit leftovers (aborted runs leave gaps)
+
+    // Optional: stream every committed event to a deposition trace (nullptr disables)
+    void SetTraceWriter(DepositTraceWriter* w) { fTrace = w; }
+
+    // Optional: interleave vacancy kinetics with irradiation; the KMC clock
+    // advances by its dtPerEvent_s after every committed event (nullptr disables)
+    void SetKMC(VacancyKMC* kmc) { fKMC = kmc; }
+
+    // Optional: refresh the potential every refreshEvery committed events.
+    // Only the permittivity copy happens under the commit lock; the solve runs
+    // on the solver's worker thread and its field reaches the KMC at the next
+    // refresh boundary (PotentialSolver::BeginRefresh / FinishRefresh).
+    void SetPotentialSolver(PotentialSolver* solver) { fPotential = solver; }
+
+    // Optional: time ProcessEvent and record touched voxels / created vacancies
+    void SetPerfMonitor(PerfMonitor* perf) { fPerf = perf; }
+
+    // Continuation of an earlier run (checkpoint restart): event IDs of this
+    // run are offset by 'base' before they reach the vacancy model and trace.
+    // Workers read it, together with the event seed, to reseed each event.
+    void SetEventBase(long long base) { fEventBase = base; }
+    long long EventBase() const { return fEventBase; }
+    void SetEventSeed(uint64_t seed) { fEventSeed = seed; }
+    uint64_t EventSeed() const { return fEventSeed; }
+
+    // Optional: write a checkpoint every 'every' committed events (0 disables).
+    // The state is copied under the commit lock at the exact event boundary
+    // and written to disk after it is released, so other threads keep
+    // committing while the file is written.
+    void SetCheckpoint(const std::string& path, long long every) {
+        fCheckpointPath = path;
+        fCheckpointEvery = every;
+    }
+
+    long long Committed() const;
+    size_t Pending() const;
+
+    // The vacancy model reached its stop condition (filament with
+    // stopOnPercolation): later events are dropped so the final state ends at
+    // the spanning event regardless of scheduling; workers should abort.
+    bool Stopped() const;
+    long long Dropped() const;
+
+private:
+    void Apply(EventRecord& rec);
+    void WriteCheckpoint(std::string&& bytes, long long events);   // outside fMutex
+
+    VoxelGrid& fGrid;
+    VacancyModel& fVacancy;
+    DepositTraceWriter* fTrace = nullptr;
+    VacancyKMC* fKMC = nullptr;
+    PotentialSolver* fPotential = nullptr;
+    PerfMonitor* fPerf = nullptr;
+
+    mutable std::mutex fMutex;
+    std::map<long long, EventRecord> fPending;
+    long long fNextId{0};
+    long long fCommitted{0};
+    long long fDropped{0};
+
+    long long fEventBase{0};
+    uint64_t fEventSeed{0};
+    std::string fCheckpointPath;
+    long long fCheckpointEvery{0};
+    std::string fSnapshot;            // taken in Apply, written by the committing thread
+    long long fSnapshotEvents{0};
+    std::mutex fWriteMutex;           // one writer at a time; an older snapshot never
+    long long fWrittenEvents{-1};     // replaces a newer file
+};
@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+// Sparse per-event deposition: touched voxels (in first-touch order) and their edep in eV.
+struct EventRecord {
+    long long eventId = -1;
+    std::vector<size_t> flat;
+    std::vector<double> edep_eV;
+
+    void Clear() {
+        eventId = -1;
+        flat.clear();
+        edep_eV.clear();
+    }
+
+    size_t Size() const { return flat.size(); }
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Binary min-heap over ids 0..n-1 with a position index, so the key of any id
+// can be changed in O(log n). Used as the event queue of the KMC engine
+// (key = absolute firing time, +inf for channels that cannot fire).
+class IndexedMinHeap {
+public:
+    static constexpr double kNever = std::numeric_limits<double>::infinity();
+
+    // Take ownership of one key per id and heapify in O(n).
+    void Build(std::vector<double>&& keys) {
+        fKey = std::move(keys);
+        const size_t n = fKey.size();
+        fHeap.resize(n);
+        fPos.resize(n);
+        for (size_t i = 0; i < n; ++i) { fHeap[i] = i; fPos[i] = i; }
+        for (size_t i = n / 2; i-- > 0;) SiftDown(i);
+    }
+
+    // Append a new id (= the previous Size()) with the given key.
+    size_t Push(double key) {
+        const size_t id = fKey.size();
+        fKey.push_back(key);
+        fHeap.push_back(id);
+        fPos.push_back(id);
+        SiftUp(id);
+        return id;
+    }
+
+    size_t Size() const { return fHeap.size(); }
+    bool Empty() const { return fHeap.empty(); }
+
+    size_t Top() const { return fHeap[0]; }
+    double TopKey() const { return fKey[fHeap[0]]; }
+    double Key(size_t id) const { return fKey[id]; }
+
+    void Update(size_t id, double key) {
+        const double old = fKey[id];
+        fKey[id] = key;
+        if (key < old) SiftUp(fPos[id]);
+        else if (key > old) SiftDown(fPos[id]);
+    }
+
+    size_t MemoryBytes() const {
+        return fKey.size() * sizeof(double) + (fHeap.size() + fPos.size()) * sizeof(size_t);
+    }
+
+private:
+    void Place(size_t slot, size_t id) { fHeap[slot] = id; fPos[id] = slot; }
+
+    void SiftUp(size_t slot) {
+        const size_t id = fHeap[slot];
+        const double key = fKey[id];
+        while (slot > 0) {
+            const size_t parent = (slot - 1) / 2;
+            if (!(key < fKey[fHeap[parent]])) break;
+            Place(slot, fHeap[parent]);
+            slot = parent;
+        }
+        Place(slot, id);
+    }
+
+    void SiftDown(size_t slot) {
+        const size_t n = fHeap.size();
+        const size_t id = fHeap[slot];
+        const double key = fKey[id];
+        for (;;) {
+            size_t child = 2 * slot + 1;
+            if (child >= n) break;
+            if (child + 1 < n && fKey[fHeap[child + 1]] < fKey[fHeap[child]]) ++child;
+            if (!(fKey[fHeap[child]] < key)) break;
+            Place(slot, fHeap[child]);
+            slot = child;
+        }
+        Place(slot, id);
+    }
+
+    std::vector<double> fKey;   // by id
+    std::vector<size_t> fHeap;  // slot -> id
+    std::vector<size_t> fPos;   // id -> slot
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "ChunkedArray.hh"
+
+class VoxelGrid;
+class VacancyModel;
+class PotentialSolver;
+
+// Trap-assisted tunnelling current through the HfO2 layer (reduced form of
+// get_PTAT_rates / current_PTAT in First_Reaction_Method/main.ipynb).
+//
+// Every voxel holding n > 0 vacancies is one trap site with n equivalent
+// traps at the voxel centre and a mean occupancy f. The trap level sits
+// trapDepth below the oxide conduction band, E_c = barrier - phi (eV, relative
+// to the electrode Fermi level at zero bias), with phi from PotentialSolver
+// (or a uniform field if none is given).
+//
+// Rates per trap, kappa = sqrt(2 m* trapDepth) / hbar:
+//   trap i -> trap j   nuTrap * exp(-2 kappa d_ij) * min(1, exp(-(E_j - E_i)/kT))
+//   electrode <-> i    nuElectrode * exp(-2 kappa d) * Fermi-Dirac factor
+// Pairs and electrode couplings beyond cutoffNm are dropped. Neighbours are
+// found through the voxel grid itself (a cell list with a precomputed stencil
+// of index offsets within the cutoff), so assembly is O(sites x stencil).
+// The steady-state occupancies f_i = in_i / (in_i + out_i) are found by
+// (over-relaxed) Gauss-Seidel iteration on the sparse site graph.
+class LeakageCurrent {
+public:
+    struct Params {
+        double trapDepth_eV   = 1.2;    // below the conduction band
+        double barrier_eV     = 1.7;    // electrode work function - oxide affinity
+        double mEff           = 0.1;    // tunnelling mass / m_e
+        double cutoffNm       = 3.0;
+        double nuTrap_Hz      = 1e13;
+        double nuElectrode_Hz = 1e13;
+        double T_K            = 300.0;
+        double tolerance      = 1e-8;   // max relative occupancy change per sweep
+        double omega          = 1.8;    // over-relaxation (1 = plain Gauss-Seidel)
+        int maxIterations     = 10000;
+        bool enabled          = false;
+    };
+
+    Params& GetParams() { return fP; }
+    const Params& GetParams() const { return fP; }
+
+    // Collect trap sites and assemble all rates. 'field' may be nullptr, in
+    // which case the potential is linear between Vbottom and Vtop.
+    void Build(const VoxelGrid& grid, const VacancyModel& vac,
+               const PotentialSolver* field, double Vbottom_V, double Vtop_V);
+
+    // Steady-state occupancy; returns the number of sweeps.
+    int Solve();
+
+    // Electron current (A) leaving through the top / bottom electrode;
+    // in steady state Top() == -Bottom().
+    double CurrentTop_A() const;
+    double CurrentBottom_A() const;
+
+    size_t Sites() const { return fSites.size(); }
+    size_t Pairs() const { return fNbr.size(); }
+    double Change() const { return fChange; }
+
+    void WriteSummaryRows(std::ostream& out) const;   // key,value rows
+
+private:
+    struct Site {
+        size_t flat;
+        double n;              // traps in the voxel
+        double f;              // occupancy
+        double cTop, eTop;     // capture from / emission to the top electrode
+        double cBot, eBot;
+    };
+
+    double ElectrodeCurrent(bool top) const;
+
+    Params fP;
+    std::vector<Site> fSites;
+    ChunkedArray<int32_t> fSiteOf;   // voxel -> site id, -1 if empty
+
+    // CSR over sites: neighbours with the per-trap rates i->j and j->i
+    std::vector<size_t> fOffset;
+    std::vector<int32_t> fNbr;
+    std::vector<double> fOut, fIn;
+
+    double fChange{0};
+    int fIterations{0};
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Minimal NumPy .npy (format 1.0) writer: little-endian raw array after a
+// fixed-size header, written through a large stdio buffer. Files load with
+// np.load(path, mmap_mode='r') without any parsing.
+//
+// The header is padded to a fixed length so the leading dimension can be
+// patched in Close() when the row count is not known up front (sparse exports).
+class NpyWriter {
+public:
+    NpyWriter() = default;
+    ~NpyWriter() { Close(); }
+    NpyWriter(const NpyWriter&) = delete;
+    NpyWriter& operator=(const NpyWriter&) = delete;
+
+    // descr: NumPy dtype string, e.g. "<f8", "<u4", "<i4"
+    bool Open(const std::string& path, const std::string& descr, const std::vector<size_t>& shape);
+
+    void Write(const void* data, size_t bytes);
+
+    template <class T>
+    void Write(const T* data, size_t count) { Write((const void*)data, count * sizeof(T)); }
+
+    // Write count values converted to T by f through a small buffer; values
+    // that already are T are written as they are (f must be the identity then).
+    template <class T, class U, class F>
+    void WriteAs(const U* data, size_t count, F&& f) {
+        if constexpr (std::is_same<T, U>::value) {
+            Write(data, count);
+        } else {
+            T buf[1024];
+            for (size_t i = 0; i < count; i += 1024) {
+                const size_t n = std::min<size_t>(1024, count - i);
+                for (size_t j = 0; j < n; ++j) buf[j] = f(data[i + j]);
+                Write(buf, n);
+            }
+        }
+    }
+
+    // Replace shape[0] in the header (rows written by a sparse export).
+    void SetLeadingDim(size_t n) { if (!fShape.empty()) fShape[0] = n; }
+
+    bool Close();
+
+    bool IsOpen() const { return fFile != nullptr; }
+
+    template <class T> static const char* Descr();
+
+private:
+    std::string Header() const;
+
+    std::FILE* fFile = nullptr;
+    std::vector<char> fBuffer;
+    std::string fDescr;
+    std::vector<size_t> fShape;
+};
+
+template <> inline const char* NpyWriter::Descr<double>()   { return "<f8"; }
+template <> inline const char* NpyWriter::Descr<float>()    { return "<f4"; }
+template <> inline const char* NpyWriter::Descr<uint32_t>() { return "<u4"; }
+template <> inline const char* NpyWriter::Descr<int32_t>()  { return "<i4"; }
+template <> inline const char* NpyWriter::Descr<uint8_t>()  { return "|u1"; }
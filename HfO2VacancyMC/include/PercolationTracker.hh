@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "ChunkedArray.hh"
+#include "VoxelLayout.hh"
+#include "VoxelStorage.hh"
+
+// Incremental disjoint-set forest over occupied voxels (6-connectivity) with
+// two virtual nodes for the electrodes: kTop joins every occupied voxel in the
+// iz = Nz-1 layer (z = 0), kBottom every one in iz = 0 (Si interface). A
+// conductive filament exists once both virtual nodes share a root.
+//
+// Voxels can only be added (union-find has no delete); if vacancies are also
+// removed (KMC), call Rebuild() to start over from the current counts.
+class PercolationTracker {
+public:
+    static constexpr int32_t kTop = 0;
+    static constexpr int32_t kBottom = 1;
+
+    // Same flat indices as the vacancy counts ('layout' of the grid)
+    void Configure(const VoxelLayout& layout, int nz) {
+        fLayout = layout;
+        fNz = nz;
+        fNode.Configure(layout.Size(), -1);
+        Clear();
+    }
+
+    bool IsConfigured() const { return fNode.Size() > 0; }
+
+    void Clear() {
+        fNode.Reset();
+        fParent.assign({kTop, kBottom});
+        fSize.assign({0, 0});
+    }
+
+    // Full sweep over the vacancy counts (O(N alpha(N))).
+    void Rebuild(const ChunkedArray<VoxelStorage::Count>& vac) {
+        Clear();
+        vac.ForEachChunk([&](size_t chunk, const VoxelStorage::Count* n, size_t count) {
+            const size_t first = chunk * ChunkedArray<VoxelStorage::Count>::kChunk;
+            for (size_t i = 0; i < count; ++i) {
+                if (n[i] > 0) Occupy(first + i);
+            }
+        });
+    }
+
+    // Mark a voxel occupied and merge it with its occupied neighbours.
+    void Occupy(size_t flat) {
+        if (fNode.Get(flat) >= 0) return;
+        const int32_t id = (int32_t)fParent.size();
+        fNode[flat] = id;
+        fParent.push_back(id);
+        fSize.push_back(1);
+
+        size_t nb[6];
+        const int k = fLayout.Neighbors6(flat, nb);
+        for (int j = 0; j < k; ++j) Join(id, nb[j]);
+
+        int ix, iy, iz;
+        fLayout.Unflatten(flat, ix, iy, iz);
+        if (iz == 0)       Union(id, kBottom);
+        if (iz == fNz - 1) Union(id, kTop);
+    }
+
+    bool IsOccupied(size_t flat) const { return fNode.Get(flat) >= 0; }
+    bool Spanning() { return Find(kTop) == Find(kBottom); }
+
+    size_t OccupiedVoxels() const { return fParent.size() - 2; }
+    // Voxels in the cluster attached to the top electrode
+    size_t TopClusterVoxels() { return fSize[Find(kTop)]; }
+
+    size_t MemoryBytes() const {
+        return fNode.MemoryBytes() + fParent.capacity() * sizeof(int32_t) + fSize.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    void Join(int32_t id, size_t neighbour) {
+        const int32_t other = fNode.Get(neighbour);
+        if (other >= 0) Union(id, other);
+    }
+
+    int32_t Find(int32_t a) {
+        while (fParent[a] != a) {
+            fParent[a] = fParent[fParent[a]];   // path halving
+            a = fParent[a];
+        }
+        return a;
+    }
+
+    void Union(int32_t a, int32_t b) {
+        a = Find(a); b = Find(b);
+        if (a == b) return;
+        if (fSize[a] < fSize[b]) std::swap(a, b);
+        fParent[b] = a;
+        fSize[a] += fSize[b];
+    }
+
+    VoxelLayout fLayout;
+    int fNz{0};
+    ChunkedArray<int32_t> fNode;     // voxel -> node id, -1 if empty
+    std::vector<int32_t> fParent;
+    std::vector<uint32_t> fSize;     // voxels per root (virtual nodes count 0)
+};
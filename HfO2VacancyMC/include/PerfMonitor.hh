@@ -0,0 +1,89 @@
+#pragma once
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+class G4VPhysicalVolume;
+
+// Run instrumentation (/perf/): steps per volume, touched voxels and created
+// vacancies per event, and cumulative wall time per phase. Always compiled;
+// when disabled every hook is one branch on Enabled().
+//
+// Workers fill a thread-local EventSample (steps, scoring time, event wall
+// time) and merge it once per event; ProcessEvent is timed by EventCommitter
+// under its own lock. Transport and scoring times are summed over worker
+// threads (thread-seconds), the other phases are master wall time.
+class PerfMonitor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Phase { kTransport, kScoring, kProcessEvent, kPostRun, kExport, kNPhases };
+
+    struct Params {
+        bool enabled = false;
+        int interval = 10000;   // committed events between throughput lines; 0 = none
+    };
+
+    // Per-event counters of one worker thread
+    struct EventSample {
+        std::vector<std::pair<const G4VPhysicalVolume*, long long>> steps;
+        double scoring_s{0};
+        Clock::time_point start;
+
+        void Begin() {
+            for (auto& s : steps) s.second = 0;
+            scoring_s = 0.0;
+            start = Clock::now();
+        }
+        void CountStep(const G4VPhysicalVolume* vol) {
+            for (auto& s : steps) {
+                if (s.first == vol) { ++s.second; return; }
+            }
+            steps.emplace_back(vol, 1);
+        }
+    };
+
+    static double Seconds(Clock::time_point t0) {
+        return std::chrono::duration<double>(Clock::now() - t0).count();
+    }
+
+    Params& GetParams() { return fP; }
+    bool Enabled() const { return fP.enabled; }
+
+    void Reset();                                 // start of run (master)
+    void EndEvent(const EventSample& sample);     // end of event (any worker)
+    void AddProcessEvent(double sec, size_t touched, long long created);   // committed event
+    void AddPhase(Phase phase, double sec);
+
+    long long Events() const;
+    long long Steps() const;
+
+    void Print() const;                           // summary to G4cout
+    void WriteCSV(const std::string& path) const; // key,value rows
+    void Dump();                                  // /perf/dump: Print() and perf.csv
+
+private:
+    // log2 bins: 0, 1, 2-3, 4-7, ...
+    struct Histogram {
+        std::vector<long long> bins;
+        long long n{0}, max{0};
+        double sum{0};
+        void Add(long long v);
+        void Write(std::ostream& out, const std::string& key) const;
+    };
+
+    void WriteRows(std::ostream& out) const;
+
+    Params fP;
+    mutable std::mutex fMutex;
+    Clock::time_point fStart, fLastReport;
+    std::map<std::string, long long> fStepsByVolume;
+    long long fSteps{0}, fEvents{0};
+    long long fLastSteps{0}, fLastEvents{0};
+    double fPhase_s[kNPhases]{};
+    Histogram fTouched, fCreated;
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Counter-based random numbers (Philox4x32-10, Salmon et al., SC'11): block n
+// of a stream is a pure function of (key, stream, n), so streams can be drawn
+// in any order and on any thread with the same result.
+class Philox4x32 {
+public:
+    using Block = std::array<uint32_t, 4>;
+
+    static Block Generate(Block ctr, uint64_t key) {
+        uint32_t k0 = (uint32_t)key, k1 = (uint32_t)(key >> 32);
+        for (int round = 0; round < 10; ++round) {
+            const uint64_t p0 = (uint64_t)0xD2511F53u * ctr[0];
+            const uint64_t p1 = (uint64_t)0xCD9E8D57u * ctr[2];
+            ctr = {(uint32_t)(p1 >> 32) ^ ctr[1] ^ k0, (uint32_t)p1,
+                   (uint32_t)(p0 >> 32) ^ ctr[3] ^ k1, (uint32_t)p0};
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        return ctr;
+    }
+};
+
+// Sequential uniforms of one stream: counter = (block index, stream id)
+class PhiloxStream {
+public:
+    PhiloxStream(uint64_t key, uint64_t stream) : fKey(key), fStream(stream) {}
+
+    // 53-bit uniform in (0, 1]
+    double Uniform() {
+        if (fUsed == 4) Refill();
+        const uint64_t hi = fBlock[fUsed], lo = fBlock[fUsed + 1];
+        fUsed += 2;
+        return (double)(((hi << 32 | lo) >> 11) + 1) * 0x1.0p-53;
+    }
+
+private:
+    void Refill() {
+        fBlock = Philox4x32::Generate({(uint32_t)fNext, (uint32_t)(fNext >> 32),
+                                       (uint32_t)fStream, (uint32_t)(fStream >> 32)}, fKey);
+        ++fNext;
+        fUsed = 0;
+    }
+
+    uint64_t fKey, fStream;
+    uint64_t fNext{0};
+    Philox4x32::Block fBlock{};
+    int fUsed{4};
+};
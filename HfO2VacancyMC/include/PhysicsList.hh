@@ -0,0 +1,53 @@
+#pragma once
+#include "G4VModularPhysicsList.hh"
+#include "G4GenericMessenger.hh"
+#include "G4String.hh"
+#include "PhysicsTableCache.hh"
+
+class G4VPhysicsConstructor;
+
+// EM physics with the low-energy models confined to HfO2Region (/phys/).
+//
+//   /phys/em regional   (default) standard option in the world and the Si
+//                       substrate (SiRegion), Livermore in HfO2Region
+//   /phys/em microelec  standard option outside, MicroElec in HfO2Region
+//                       (needs MicroElec cross sections for the oxide)
+//   /phys/em livermore  Livermore everywhere: the reference setup
+//   /phys/standardOption 0|1|2|3|4 G4EmStandardPhysics[_optionN] outside HfO2
+//
+// Both must be given before /run/initialize. Cuts stay per region:
+// HfO2Region sets its own in DetectorConstruction, SiRegion and the world use
+// the default cut (/run/setCut, /run/setCutForRegion SiRegion ...).
+//
+// Fidelity vs throughput: run macros/physics_compare.mac once per mode
+// (HFO2_EM=livermore|regional|microelec) and compare perf.csv (steps_SiPV,
+// events_per_s) against the vacancy and edep rows of the summaries.
+//
+// The step limit in HfO2 (/det/hfo2MaxStepNm) is honoured by
+// G4StepLimiterPhysics, always registered.
+//
+//   /phys/tableCache <dir>   reuse built physics tables across invocations
+//                            (see PhysicsTableCache; empty disables)
+class PhysicsList : public G4VModularPhysicsList {
+public:
+    PhysicsList();
+    ~PhysicsList() override;
+
+    void ConstructParticle() override;
+    void ConstructProcess() override;
+
+    void SetEmMode(const G4String& mode);
+    void SetStandardOption(G4int option);
+    void SetTableCache(const G4String& dir) { fCache.SetDirectory(dir); }
+
+private:
+    void BuildEm();   // (re)create the EM constructor and its region setup
+
+    G4String fEmMode = "regional";
+    G4int fStandardOption = 0;
+    G4VPhysicsConstructor* fEm = nullptr;
+    G4VPhysicsConstructor* fStepLimiter = nullptr;
+    PhysicsTableCache fCache{this};
+
+    G4GenericMessenger* fMessenger = nullptr;
+};
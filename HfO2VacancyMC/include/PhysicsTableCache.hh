@@ -0,0 +1,48 @@
+#pragma once
+#include "G4VStateDependent.hh"
+#include "G4String.hh"
+
+#include <chrono>
+#include <string>
+
+class G4VUserPhysicsList;
+
+// Managed cache of built physics tables (/phys/tableCache <dir>).
+//
+// At the end of /run/initialize the inputs of the tables are written out as a
+// signature text: Geant4 version, the physics-list tag (EM mode and option),
+// every material (density, composition, mean excitation energy), the
+// production cuts of every region and G4EmParameters. Tables live in
+// <dir>/<64-bit hash of the signature>/ next to a copy of that text; if it
+// matches, the tables are retrieved instead of built. Otherwise they are built
+// as usual and stored there once the first run starts, through a temporary
+// directory renamed into place, so concurrent jobs never read a partial cache.
+// Any change of materials, cuts or EM settings gives a new signature.
+//
+// Cuts changed after /run/initialize are not part of the signature (Geant4
+// still refuses a retrieved cut table that does not match).
+class PhysicsTableCache : public G4VStateDependent {
+public:
+    explicit PhysicsTableCache(G4VUserPhysicsList* list);
+
+    void SetDirectory(const G4String& dir) { fRoot = dir; }
+    void SetTag(const G4String& tag) { fTag = tag; }
+
+    G4bool Notify(G4ApplicationState requested) override;
+
+    // Signature text of the current setup
+    static std::string Signature(const std::string& tag);
+
+private:
+    void Prepare();       // end of /run/initialize: look up, retrieve on a hit
+    void StoreIfNew();    // tables built (first run): store on a miss, report timing
+
+    G4VUserPhysicsList* fList = nullptr;
+    G4String fRoot;
+    G4String fTag;
+
+    std::string fSignature;
+    std::string fEntry;   // <root>/<hash>
+    bool fPrepared{false}, fHit{false}, fDone{false};
+    std::chrono::steady_clock::time_point fStart;
+};
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "VoxelLayout.hh"
+
+class VoxelGrid;
+class VacancyModel;
+
+// Electrostatic potential in the HfO2 layer, div(eps grad phi) = 0 on the
+// voxel grid (port of get_potential_distribution_iteration from
+// First_Reaction_Method/main.ipynb):
+//   - Dirichlet at the bottom (iz = 0, Si interface: Vbottom) and top
+//     (iz = Nz-1 side, z = 0: Vtop) faces, Neumann on the pad sides;
+//   - relative permittivity per voxel mixed linearly between epsOxide and
+//     epsDefect by the vacancy fill fraction n/cap of VacancyModel;
+//   - cell-centred finite volumes, harmonic-mean face permittivity.
+//
+// Geometric multigrid V-cycles. Voxels are much thinner than wide, so the
+// smoother is red-black Gauss-Seidel over z-lines (each column solved exactly)
+// and only x, y are coarsened. Solutions are kept between calls as warm starts.
+//
+// In a run the potential is refreshed every refreshEvery committed events
+// without holding up the commits: BeginRefresh copies the permittivity from
+// the counts (at the commit boundary) and runs the V-cycles on a worker
+// thread; FinishRefresh, at the next boundary, waits for them and publishes
+// the field. A field solved from the counts at boundary k is thus seen from
+// boundary k+1 on, however long the solve took. VacancyKMC reads the
+// published field for field-assisted generation.
+class PotentialSolver {
+public:
+    struct Params {
+        double Vtop_V      = 1.0;
+        double Vbottom_V   = 0.0;
+        double epsOxide    = 25.0;
+        double epsDefect   = 1000.0;
+        double tolerance   = 1e-8;     // relative residual
+        int maxCycles      = 50;
+        int smoothSweeps   = 2;        // pre- and post-smoothing per level
+        int refreshEvery   = 0;        // committed events between in-run refreshes (0 = end of run only)
+        bool enabled       = false;
+    };
+
+    Params& GetParams() { return fP; }
+    const Params& GetParams() const { return fP; }
+
+    PotentialSolver() = default;
+    ~PotentialSolver();
+
+    // Build the level hierarchy for the grid; drops the previous solution.
+    void Configure(const VoxelGrid& grid);
+
+    // Refresh permittivity from the vacancy counts and solve (warm start),
+    // then publish the field. Returns the number of V-cycles.
+    int Solve(const VacancyModel& vac);
+
+    // Pipelined in-run refresh (see above). BeginRefresh reads the model;
+    // FinishRefresh returns false if no refresh was in flight.
+    void BeginRefresh(const VacancyModel& vac);
+    bool FinishRefresh();
+
+    // |E| in V/m from the last published solve, by the model's flat index,
+    // and its maximum per storage chunk (VacancyModel::kInitChunk voxels).
+    // Unchanged while a refresh is in flight.
+    bool HasField() const { return !fField.empty(); }
+    float Field(size_t flat) const { return fField[flat]; }
+    float FieldChunkMax(size_t chunk) const { return fFieldChunkMax[chunk]; }
+
+    bool IsConfigured() const { return !fLevels.empty(); }
+    double Residual() const { return fResidual; }   // relative, after last Solve
+    int Levels() const { return (int)fLevels.size(); }
+    long long Solves() const { return fSolves; }
+
+    // Potential in V on the solver lattice: (ix,iy,iz) row-major, which is
+    // VoxelGrid::Flatten only under the row-major layout
+    const std::vector<double>& Potential() const { return fLevels.front().phi; }
+    double Potential(size_t flat) const { return fLevels.front().phi[flat]; }
+    double Potential(int ix, int iy, int iz) const {
+        const Level& L = fLevels.front();
+        return L.phi[L.Index(ix, iy, iz)];
+    }
+    // |grad phi| at the voxel centre, V/m (solver lattice index)
+    double FieldMagnitude(size_t flat) const;
+
+    void ExportNpy(const std::string& path) const;   // (Nx,Ny,Nz) float64, V
+    void ExportCSV(const std::string& path) const;   // ix,iy,iz,phi_V,E_V_per_m
+
+private:
+    struct Level {
+        int nx{0}, ny{0}, nz{0};
+        double hx{0}, hy{0}, hz{0};               // nm
+        std::vector<double> eps;                  // per cell
+        std::vector<double> cx, cy, cz;           // coupling to the +x/+y/+z neighbour
+        std::vector<double> cb, ct;               // Dirichlet couplings, per column
+        std::vector<double> diag;
+        std::vector<double> phi, rhs, res;
+
+        size_t Index(int ix, int iy, int iz) const {
+            return (size_t)iz + (size_t)nz * ((size_t)iy + (size_t)ny * (size_t)ix);
+        }
+        size_t Cells() const { return (size_t)nx * (size_t)ny * (size_t)nz; }
+    };
+
+    void UpdatePermittivity(const VacancyModel& vac);
+    void Assemble(Level& L, bool fine);
+    void Smooth(Level& L, int sweeps);
+    void SolveColumn(Level& L, int ix, int iy);
+    double Residual(Level& L);                    // fills res, returns ||res||_2
+    void Restrict(const Level& fine, Level& coarse);
+    void Prolong(const Level& coarse, Level& fine);
+    void VCycle(size_t level);
+    int Relax();                                  // V-cycles to tolerance
+    void BuildField();                            // fNextField from phi
+    void PublishField();
+    void Join();                                  // wait for a refresh in flight
+
+    Params fP;
+    std::vector<Level> fLevels;
+    double fResidual{0};
+    double fRhsNorm{0};
+    long long fSolves{0};
+
+    VoxelLayout fLayout;                          // the model's flat indices
+    std::vector<float> fField, fFieldChunkMax;    // published
+    std::vector<float> fNextField, fNextChunkMax; // being built by a refresh
+    std::future<int> fRefresh;                    // V-cycles on a worker thread
+};
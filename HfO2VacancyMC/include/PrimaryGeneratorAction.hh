@@ -4,14 +4,16 @@
 
 class G4GeneralParticleSource;
 class G4Event;
+class DetectorConstruction;
 
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction {
 public:
-    PrimaryGeneratorAction();
+    explicit PrimaryGeneratorAction(DetectorConstruction* det);
     ~PrimaryGeneratorAction() override;
 
     void GeneratePrimaries(G4Event* anEvent) override;
 
 private:
+    DetectorConstruction* fDet = nullptr;
     G4GeneralParticleSource* fGPS = nullptr;
 };
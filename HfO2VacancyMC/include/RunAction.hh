@@ -1,13 +1,17 @@
 #pragma once
 #include "G4UserRunAction.hh"
+#include "G4GenericMessenger.hh"
+#include <cstdint>
 #include <string>
 
+#include "DepositTrace.hh"
+
 class DetectorConstruction;
 
 class RunAction : public G4UserRunAction {
 public:
     explicit RunAction(DetectorConstruction* det);
-    ~RunAction() override = default;
+    ~RunAction() override;
 
     void BeginOfRunAction(const G4Run*) override;
     void EndOfRunAction(const G4Run*) override;
@@ -15,4 +19,23 @@ public:
 private:
     DetectorConstruction* fDet = nullptr;
     std::string fOutCsv = "hfO2_edep_voxels.csv";
+
+    // Per-voxel export format: "npy" (dense NumPy arrays), "sparse" (non-zero
+    // voxels only, .npy) or "csv" (legacy text). The summary is always CSV.
+    std::string fOutFormat = "npy";
+
+    // Per-event deposition trace for HfO2VacancyReplay (empty = disabled)
+    std::string fTraceFile;
+    DepositTraceWriter fTrace;
+
+    // Checkpoint/restart: periodic and end-of-run checkpoints to fCheckpointFile,
+    // fRestartFile is loaded (once) at the start of the next run
+    std::string fCheckpointFile;
+    G4int fCheckpointEvery = 0;
+    std::string fRestartFile;
+    uint64_t fEventSeed = 0;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4GenericMessenger* fOutMessenger = nullptr;
+    G4GenericMessenger* fCkptMessenger = nullptr;
 };
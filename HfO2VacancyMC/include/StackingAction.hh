@@ -0,0 +1,18 @@
+#pragma once
+#include "G4UserStackingAction.hh"
+
+class DetectorConstruction;
+
+// Substrate secondaries (/substrate/): electrons born below the HfO2 layer
+// that cannot range back to it are never tracked; low-energy ones may play
+// Russian roulette (see SubstrateKiller).
+class StackingAction : public G4UserStackingAction {
+public:
+    explicit StackingAction(DetectorConstruction* det);
+    ~StackingAction() override = default;
+
+    G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track) override;
+
+private:
+    DetectorConstruction* fDet = nullptr;
+};
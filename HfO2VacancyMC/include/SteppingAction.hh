@@ -2,14 +2,19 @@
 #include "G4UserSteppingAction.hh"
 
 class DetectorConstruction;
+class EventAction;
 
 class SteppingAction : public G4UserSteppingAction {
 public:
-    explicit SteppingAction(DetectorConstruction* det);
+    SteppingAction(DetectorConstruction* det, EventAction* evt);
     ~SteppingAction() override = default;
 
     void UserSteppingAction(const G4Step* step) override;
 
 private:
+    void Score(const G4Step* step);   // HfO2 deposits into the event grid
+    void KillInSubstrate(const G4Step* step);   // /substrate/ range check
+
     DetectorConstruction* fDet = nullptr;
+    EventAction* fEvt = nullptr;
 };
@@ -0,0 +1,108 @@
+#pragma once
+#include <memory>
+#include <ostream>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ChannelQueue.hh"
+#include "VacancyKMC.hh"
+#include "VoxelLayout.hh"
+
+class VacancyModel;
+class ThreadPool;
+
+// Synchronous-sublattice parallel version of VacancyKMC (same rate law).
+//
+// The (ix,iy) plane is cut into sectors of sectorX x sectorY columns (full z),
+// coloured 2x2 like a checkerboard so that sectors of one colour never touch.
+// Each cycle runs the four colours in turn; all sectors of the active colour
+// advance their own next-reaction queue (ChannelQueue, empty voxels pooled)
+// by window_s concurrently on a thread pool. A sector only writes its own
+// voxels: hops leaving it are parked in an outbox and reconciled after the
+// phase, in sector order. Until then the
+// vacancy still holds its slot at the source but no longer fires there; a hop
+// whose target filled up in the meantime is a boundary conflict and is
+// rejected (the vacancy stays at its source). Counts never exceed the
+// capacity. Results do not depend on the thread count.
+//
+// Neighbour counts outside the active sector are frozen during a phase, which
+// is the usual sublattice approximation; it vanishes as window_s -> 0.
+class SublatticeKMC {
+public:
+    explicit SublatticeKMC(const VacancyKMC::Params& p);
+    ~SublatticeKMC();
+
+    void Attach(VacancyModel& model);   // dense storage, see VacancyKMC::DenseCounts
+    long long Advance(double dt_s);     // returns the number of firings
+
+    double Time() const { return fTime; }
+    unsigned Threads() const;
+    size_t Sectors() const { return fSectors.size(); }
+
+    long long Steps() const;
+    long long Generated() const;
+    long long Recombined() const;
+    long long Hops() const;              // accepted, including across sectors
+    long long BoundaryEvents() const;    // hops that left their sector
+    long long Conflicts() const { return fConflicts; }
+
+    // Busy thread-time over available thread-time in the parallel phases
+    double ParallelEfficiency() const;
+    // Rejected boundary hops per boundary hop
+    double ConflictRate() const;
+
+    void WriteSummaryRows(std::ostream& out) const;   // key,value rows
+
+private:
+    struct Sector {
+        int x0{0}, x1{0}, y0{0}, y1{0};
+        ChannelQueue queue;               // over local ids
+        std::mt19937_64 rng;
+        std::vector<std::pair<size_t, size_t>> outbox;   // (source, target) flat
+        std::unordered_map<size_t, uint32_t> transit;    // local -> outbox hops from it
+        long long steps{0}, generated{0}, recombined{0}, hops{0}, boundary{0};
+        double busy_s{0};
+    };
+
+    bool Inside(const Sector& s, int ix, int iy) const {
+        return ix >= s.x0 && ix < s.x1 && iy >= s.y0 && iy < s.y1;
+    }
+    size_t Local(const Sector& s, int ix, int iy, int iz) const {
+        return ((size_t)(ix - s.x0) * (size_t)(s.y1 - s.y0) + (size_t)(iy - s.y0)) * (size_t)fNz + (size_t)iz;
+    }
+    void Decode(const Sector& s, size_t local, int& ix, int& iy, int& iz) const;
+    size_t Flat(int ix, int iy, int iz) const { return fLayout.Flatten(ix, iy, iz); }
+
+    void InitSector(Sector& s, size_t index);
+    uint32_t Transit(const Sector& s, size_t local) const {
+        const auto it = s.transit.find(local);
+        return it == s.transit.end() ? 0 : it->second;
+    }
+    // transit: vacancies of this voxel waiting in the outbox (hold a slot, do not fire)
+    double ChannelRate(int ix, int iy, int iz, uint32_t transit = 0) const;
+    void Reschedule(Sector& s, size_t local, double now);
+    void RescheduleAround(Sector& s, int ix, int iy, int iz, double now);
+    void Fire(Sector& s, size_t ch);
+    size_t FirePool(Sector& s, size_t block);   // returns the local id
+    void RunPhase(Sector& s, double tEnd);
+    void Reconcile(const std::vector<size_t>& sectors);
+
+    VacancyKMC::Params fP;
+    std::unique_ptr<ThreadPool> fPool;
+
+    VacancyModel* fModel = nullptr;
+    VoxelStorage::Count* fVac = nullptr;
+    uint32_t fCap{0};
+    int fNx{0}, fNy{0}, fNz{0};
+    VoxelLayout fLayout;   // the model's flat indices
+    double fRg{0}, fRr{0}, fRd{0};
+
+    std::vector<Sector> fSectors;
+    std::vector<size_t> fByColour[4];
+
+    double fTime{0};
+    long long fConflicts{0};
+    double fPhaseWall_s{0};
+};
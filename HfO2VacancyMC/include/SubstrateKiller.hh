@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <ostream>
+#include <vector>
+
+#include "G4ThreeVector.hh"
+
+class G4Material;
+
+// Variance reduction in the Si substrate (/substrate/). Only electrons that
+// come back up into the HfO2 layer matter there, so an electron below the
+// interface is killed once its CSDA range (times rangeSafety, for straggling)
+// is shorter than its depth: even a straight path could not reach the oxide.
+// Optionally, low-energy secondaries created in the substrate play Russian
+// roulette: they survive with probability 'rouletteSurvival' and carry weight
+// 1/rouletteSurvival, which VoxelGrid::AddEdep applies to their deposits.
+//
+// The range table is built on the master at the start of each run and only
+// read by the workers.
+class SubstrateKiller {
+public:
+    struct Params {
+        bool enabled              = false;
+        double rangeSafety        = 1.2;     // CSDA range multiplier
+        double maxEnergy_keV      = 100.0;   // range table top; faster electrons are never killed
+        bool roulette             = false;
+        double rouletteEnergy_keV = 1.0;     // secondaries below this play roulette
+        double rouletteSurvival   = 0.25;
+    };
+
+    Params& GetParams() { return fP; }
+    const Params& GetParams() const { return fP; }
+    bool Enabled() const { return fP.enabled; }
+
+    // Range table for 'si' between minEnergy and maxEnergy_keV; the oxide/Si
+    // interface is the plane z = interfaceZ with the substrate below it.
+    void Prepare(const G4Material* si, G4double minEnergy, G4double interfaceZ);
+
+    G4double Depth(const G4ThreeVector& p) const { return fInterfaceZ - p.z(); }
+    G4double CsdaRange(G4double ekin) const;
+    bool Unreachable(G4double ekin, G4double depth) const {
+        return depth > 0.0 && fP.rangeSafety * CsdaRange(ekin) < depth;
+    }
+
+    // Roulette for a new substrate secondary: false = kill, else 'weight' is
+    // updated for the survivor.
+    bool Roulette(G4double ekin, G4double& weight);
+
+    void CountKilled(bool inFlight) { (inFlight ? fKilledInFlight : fKilledAtBirth)++; }
+    void ResetCounters();
+    void WriteSummaryRows(std::ostream& out) const;   // key,value rows
+
+private:
+    Params fP;
+    G4double fInterfaceZ{0};
+    G4double fLogE0{0}, fInvDlogE{0};
+    std::vector<G4double> fEnergy, fRange;
+
+    std::atomic<long long> fKilledAtBirth{0}, fKilledInFlight{0};
+    std::atomic<long long> fRouletteKilled{0}, fRouletteSurvived{0};
+};
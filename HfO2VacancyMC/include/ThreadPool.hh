@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Minimal fork-join pool: ParallelFor(n, f) runs f(0..n-1) on the workers and
+// the calling thread and returns when all calls are done. Workers persist
+// across calls, so short parallel phases do not pay thread start-up.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned nThreads) {
+        for (unsigned i = 1; i < nThreads; ++i) fWorkers.emplace_back([this] { WorkerLoop(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fStop = true;
+        }
+        fWake.notify_all();
+        for (auto& t : fWorkers) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned Size() const { return (unsigned)fWorkers.size() + 1; }
+
+    void ParallelFor(size_t n, const std::function<void(size_t)>& f) {
+        if (n == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            fTask = &f;
+            fCount = n;
+            fNext.store(0);
+            fBusy = fWorkers.size();
+            ++fGeneration;
+        }
+        fWake.notify_all();
+
+        Drain();
+
+        std::unique_lock<std::mutex> lock(fMutex);
+        fDone.wait(lock, [this] { return fBusy == 0; });
+        fTask = nullptr;
+    }
+
+private:
+    void Drain() {
+        for (size_t i = fNext.fetch_add(1); i < fCount; i = fNext.fetch_add(1)) (*fTask)(i);
+    }
+
+    void WorkerLoop() {
+        size_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(fMutex);
+                fWake.wait(lock, [&] { return fStop || fGeneration != seen; });
+                if (fStop) return;
+                seen = fGeneration;
+            }
+            Drain();
+            {
+                std::lock_guard<std::mutex> lock(fMutex);
+                if (--fBusy == 0) fDone.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> fWorkers;
+    std::mutex fMutex;
+    std::condition_variable fWake, fDone;
+
+    const std::function<void(size_t)>* fTask = nullptr;
+    size_t fCount{0};
+    std::atomic<size_t> fNext{0};
+    size_t fBusy{0};
+    size_t fGeneration{0};
+    bool fStop{false};
+};
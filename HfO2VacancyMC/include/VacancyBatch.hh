@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <memory>
+
+#include "ChunkedArray.hh"
+#include "VacancyModel.hh"
+
+class VoxelGrid;
+struct EventRecord;
+
+// K parameter sets ("lanes") of VacancyModel evaluated against one deposition
+// history. State is stored per storage chunk (VacancyModel::kInitChunk voxels)
+// as a voxel-major / lane-minor block (index = local*K + lane), so the bank
+// update, neighbour probe and threshold test of one touched voxel are a
+// contiguous loop over the lanes that the compiler turns into SIMD. Blocks are
+// allocated on first touch (counts drawn per lane as VacancyModel draws the
+// chunk), so memory follows the beam footprint: K * kInitChunk *
+// (sizeof(Count) + sizeof(Bank)) bytes per touched or probed chunk.
+// Each lane reproduces VacancyModel with the same Params bit for bit.
+class VacancyBatch {
+public:
+    struct LaneSummary {
+        VacancyModel::Params params;
+        uint32_t capPerVoxel{0};
+        int seedCapturedElectrons{0};
+        long long totalCreated{0};
+    };
+
+    explicit VacancyBatch(std::vector<VacancyModel::Params> lanes);
+
+    void ConfigureFromGrid(const VoxelGrid& grid);
+    void ResetAndInit(const VoxelGrid& grid);    // per-lane initConc_cm3 / initSeed
+
+    void ProcessEvent(const EventRecord& ev);
+
+    size_t Lanes() const { return fK; }
+    LaneSummary Summary(size_t lane) const;
+
+    size_t AllocatedChunks() const { return fAllocated; }
+    size_t MemoryBytes() const {
+        return fAllocated * VacancyModel::kInitChunk * fK * (sizeof(VacancyModel::Count) + sizeof(VacancyModel::Bank))
+             + fVacChunk.size() * 2 * sizeof(fVacChunk[0]) + fBankStamp.MemoryBytes();
+    }
+
+    // One row per lane, columns = the keys of VacancyModel::ExportSummaryCSV
+    // (bankRelaxEvents only when a lane relaxes its banks)
+    void ExportSummaryCSV(const std::string& path, long long nPrimaries) const;
+
+private:
+    size_t Flatten(int ix, int iy, int iz) const;
+    void Unflatten(size_t flat, int& ix, int& iy, int& iz) const;
+
+    // Lane blocks of the voxel's chunk, allocated (and drawn) on first use
+    VacancyModel::Count* VacLanes(size_t flat) {
+        const size_t c = flat / VacancyModel::kInitChunk;
+        if (!fVacChunk[c]) AllocateChunk(c);
+        return &fVacChunk[c][(flat % VacancyModel::kInitChunk) * fK];
+    }
+    VacancyModel::Bank* BankLanes(size_t flat) {
+        const size_t c = flat / VacancyModel::kInitChunk;
+        if (!fVacChunk[c]) AllocateChunk(c);
+        return &fBankChunk[c][(flat % VacancyModel::kInitChunk) * fK];
+    }
+    void AllocateChunk(size_t c);
+
+private:
+    std::vector<VacancyModel::Params> fParams;
+    size_t fK{0};
+
+    int fNx{0}, fNy{0}, fNz{0};
+    VoxelLayout fLayout;   // the grid's
+    int fSeedIx{0}, fSeedIy{0}, fSeedIz{0};
+    size_t fSeedFlat{0};
+
+    // lane-minor state per storage chunk (VoxelStorage types, as VacancyModel);
+    // a chunk's count and bank blocks are allocated together
+    std::vector<std::unique_ptr<VacancyModel::Count[]>> fVacChunk;
+    std::vector<std::unique_ptr<VacancyModel::Bank[]>> fBankChunk;
+    size_t fAllocated{0};
+
+    // per-lane constants and counters
+    std::vector<uint32_t> fCap;
+    std::vector<double> fW, fEaBase, fEaFast;
+    std::vector<uint8_t> fFastEverywhere;   // !fastOnlyNearSeed
+    std::vector<double> fBankInvTau;        // 1 / bankRelaxEvents, 0 = no relaxation
+    std::vector<double> fLambda;            // mean initial vacancies/voxel
+    std::vector<int> fSeedCaptured;
+    std::vector<long long> fTotalCreated;
+
+    // bank relaxation clock, shared by the lanes (VacancyModel's per lane);
+    // one stamp per voxel since every lane sees the same touches
+    bool fBankRelax{false};
+    uint32_t fBankClock{0};
+    ChunkedArray<uint32_t> fBankStamp;
+
+    // per-event scratch (one entry per lane)
+    std::vector<uint8_t> fHasNbr;
+};
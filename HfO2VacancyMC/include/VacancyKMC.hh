@@ -0,0 +1,121 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <random>
+
+#include "ChannelQueue.hh"
+#include "VoxelLayout.hh"
+#include "VoxelStorage.hh"
+
+class VacancyModel;
+class PotentialSolver;
+struct EventRecord;
+
+// Kinetic Monte Carlo for vacancy generation / migration / recombination on
+// VacancyModel's voxel counts (next-reaction form of the first-reaction method
+// of First_Reaction_Method/main.ipynb).
+//
+// Per voxel with n vacancies out of cap sites, Arrhenius rates
+// r(E) = nu * exp(-E / kT):
+//   generation     r(Eg) * (cap - n)
+//   recombination  r(Er) * n
+//   hop to each of the 6 neighbours (if not full)  r(Ed) * n
+// With a potential attached (SetField) and genDipole_eA > 0, generation is
+// field-assisted (thermochemical model): Eg is lowered by genDipole_eA * |E|
+// with |E| from the solver's last published field.
+//
+// Each occupied voxel is one channel keyed on its next firing time in an
+// indexed heap; empty voxels only generate and are pooled per block of 4096
+// (ChannelQueue), so the queue grows with the occupied voxels, not the grid.
+// A firing changes at most two voxels, so only those and their 6 neighbours
+// are rescheduled (O(log N) each); unchanged channels keep their times.
+class VacancyKMC {
+public:
+    struct Params {
+        double T_K        = 300.0;
+        double attempt_Hz = 1e12;
+        double Ed_eV      = 0.7;    // migration (hop) barrier
+        double Eg_eV      = 1.0;    // generation
+        double genDipole_eA = 0.0;  // field-assisted generation: Eg - p|E|, p in e*Angstrom (0 = off)
+        double Er_eV      = 2.0;    // recombination
+        uint64_t seed     = 4242;
+
+        // Scheduling in a Geant4 run (0 disables each):
+        double dtPerEvent_s = 0.0;  // KMC time advanced after every committed event
+        double postTime_s   = 0.0;  // KMC time simulated after the last event
+
+        // Parallel sublattice mode for postTime_s (see SublatticeKMC):
+        int threads        = 0;     // 0 = serial engine
+        int sectorX        = 16;    // sector size in voxels (x, y; z is not split)
+        int sectorY        = 16;
+        double window_s    = 1e-3;  // time advanced per sector colour
+
+        // Both engines work on the dense count slab; refuse larger ones
+        double maxDense_MiB = 4096.0;
+    };
+
+    // Arrhenius coefficients: per free site (gen), per vacancy (rec, hop)
+    static void Coefficients(const Params& p, double& rg, double& rr, double& rd);
+
+    // The model's counts as one dense slab (densified on first use). Throws
+    // std::runtime_error if that slab would exceed p.maxDense_MiB.
+    static VoxelStorage::Count* DenseCounts(const Params& p, VacancyModel& model);
+
+    bool Enabled() const { return fP.dtPerEvent_s > 0.0 || fP.postTime_s > 0.0; }
+
+    Params& GetParams() { return fP; }
+    const Params& GetParams() const { return fP; }
+
+    // (Re)build all channels from the model's current state; resets the clock.
+    // Switches the model to dense storage (see DenseCounts).
+    void Attach(VacancyModel& model);
+    void Detach() { fModel = nullptr; }
+    bool IsAttached() const { return fModel != nullptr; }
+
+    // Field-assisted generation from the solver's published field (nullptr
+    // detaches); call FieldChanged after each publish to rescale the rates.
+    void SetField(const PotentialSolver* field);
+    void FieldChanged();
+
+    // Irradiation changed the counts of the touched voxels: reschedule them.
+    void OnEvent(const EventRecord& ev);
+
+    // Run until the clock has advanced by dt seconds (or maxSteps firings).
+    // Returns the number of firings.
+    long long Advance(double dt_s, long long maxSteps = -1);
+
+    double Time() const { return fTime; }
+    long long Steps() const { return fSteps; }
+    long long Generated() const { return fGenerated; }
+    long long Recombined() const { return fRecombined; }
+    long long Hops() const { return fHops; }
+    double TotalRate() const { return fQueue.TotalRate(); }
+
+    void WriteSummaryRows(std::ostream& out) const;   // key,value rows
+
+private:
+    double GenRate(size_t flat) const;       // per free site
+    double ChannelRate(size_t flat) const;   // occupied voxels
+    void SetEmptyRates();                    // pool bounds from the field
+    void Reschedule(size_t flat);          // after it or a neighbour changed
+    void RescheduleAround(size_t flat);    // flat and its 6 neighbours
+    void Fire(size_t ch);
+    size_t FirePool(size_t block);         // generation in an empty voxel, or kNone
+
+    Params fP;
+    VacancyModel* fModel = nullptr;
+    VoxelStorage::Count* fVac = nullptr;   // dense model counts
+    uint32_t fCap{0};
+    VoxelLayout fLayout;        // the model's flat indices
+
+    double fRg{0}, fRr{0}, fRd{0};   // per-site / per-vacancy rates
+    const PotentialSolver* fField = nullptr;
+    bool fFieldOn{false};            // field attached, published and genDipole_eA > 0
+    double fFieldGain{0};            // genDipole_eA / kT, per V/m
+    ChannelQueue fQueue;
+    std::mt19937_64 fRng;
+
+    double fTime{0};
+    long long fSteps{0}, fGenerated{0}, fRecombined{0}, fHops{0};
+};
@@ -7,7 +7,13 @@
 #include <random>
 #include <cmath>
 
+#include "ChunkedArray.hh"
+#include "PercolationTracker.hh"
+#include "VoxelLayout.hh"
+#include "VoxelStorage.hh"
+
 class VoxelGrid;
+struct EventRecord;
 
 class VacancyModel {
 public:
@@ -17,6 +23,9 @@ public:
         double Ea_base_eV       = 2.0;
         double Ea_fast_eV       = 1.3;
         bool   fastOnlyNearSeed = true;
+        // Bank relaxation: e-folding time of the energy banks in events
+        // (relaxation time times primaries per second); 0 = banks never decay
+        double bankRelaxEvents  = 0.0;
 
         // stage-2 parameters:
         double initConc_cm3     = 0.0;      // initial vacancy concentration (cm^-3)
@@ -25,6 +34,10 @@ public:
         // Material parameters for capacity calculation:
         double rho_g_cm3        = 9.68;     // HfO2 density (adjustable)
         double molarMass_g_mol  = 210.49;   // HfO2 molar mass
+
+        // Filament detection (top-to-bottom cluster of occupied voxels):
+        bool trackPercolation   = false;
+        bool stopOnPercolation  = false;    // end the run at the spanning event
     };
 
         VacancyModel() = default;
@@ -32,45 +45,178 @@ public:
     void ConfigureFromGrid(const VoxelGrid& grid);
     void ResetAndInit(const VoxelGrid& grid);    // uses Params.initConc_cm3
 
-    void ProcessEvent(const VoxelGrid& grid);
+    // Must be called in event-ID order for reproducible vacancy maps (see EventCommitter).
+    // With Params.bankRelaxEvents each call advances the bank clock by one
+    // event; a bank decays lazily when its voxel is touched again (or is
+    // exported), so the cost stays proportional to the touched voxels.
+    void ProcessEvent(const EventRecord& ev);
+
+    using Count = VoxelStorage::Count;
+    using Bank = VoxelStorage::Bank;
 
     // Getters
     long long TotalCreated() const { return fTotalCreated; }
     int SeedCapturedElectrons() const { return fSeedCapturedElectrons; }
+    uint32_t CapPerVoxel() const { return fCapPerVoxel; }
     const Params& GetParams() const { return fP; }
     Params& GetParams() { return fP; }
+    int Nx() const { return fNx; }
+    int Ny() const { return fNy; }
+    int Nz() const { return fNz; }
+    const VoxelLayout& Layout() const { return fLayout; }   // the grid's, see ConfigureFromGrid
+
+    // Percolation (only with Params.trackPercolation): event ID at which a
+    // spanning cluster first appeared, -1 if it was already present after
+    // initialization; Percolated() is false until then.
+    bool Percolated() const { return fPercolated; }
+    long long PercolationEvent() const { return fPercolationEvent; }
+    bool StopRequested() const { return fPercolated && fP.stopOnPercolation; }
+    // Re-derive the clusters from the current counts (after KMC moved vacancies)
+    // and report whether they span now.
+    bool RebuildPercolation();
+    // Spanning check after counts changed outside ProcessEvent (interleaved
+    // KMC); a new filament is attributed to eventId.
+    void UpdatePercolation(long long eventId);
+
+    // Count changes made outside ProcessEvent (KMC, Python views) must be
+    // reported so the neighbour field and the filament tracker stay current:
+    // per voxel going 0 -> 1 or 1 -> 0, or wholesale (rebuilt lazily).
+    // Emptied voxels stay in the tracker, whose clusters then only
+    // over-connect: it is rebuilt when it reports a spanning cluster.
+    void NoteOccupied(size_t flat) {
+        AdjustNeighbors(flat, +1);
+        if (fPerc.IsConfigured()) fPerc.Occupy(flat);
+    }
+    void NoteEmptied(size_t flat) {
+        AdjustNeighbors(flat, -1);
+        fPercStale = true;
+    }
+    void CountsChanged() {
+        fNbr.Reset();
+        fPercUnknown = true;
+    }
 
     void ExportVacancyCSV(const std::string& path, const VoxelGrid& grid) const;
     void ExportSummaryCSV(const std::string& path, long long nPrimaries) const;
 
+    // Exported banks are decayed to the last processed event.
+    // Binary exports (NumPy .npy, logical (ix,iy,iz) order):
+    //   dense:  <prefix>_vacCount.npy (Nx,Ny,Nz) uint32, <prefix>_Ebank_eV.npy float32
+    //           (whatever the storage types)
+    //   sparse: <prefix>_sparse_idx.npy (n,3) int32 plus _vacCount / _Ebank_eV (n,)
+    //           for voxels holding a vacancy or a non-zero bank
+    void ExportVacancyNpy(const std::string& prefix) const;
+    void ExportVacancyNpySparse(const std::string& prefix) const;
+
+    // Checkpoint of the run state (counts, banks, seed charge, counters, bank
+    // clock). LoadState() expects ResetAndInit() with the same initial-field
+    // parameters first: untouched chunks are redrawn, not stored. States
+    // saved before the bank clock existed load with withBankClock = false
+    // (banks then relax from the restart on).
+    void SaveState(std::ostream& out) const;
+    void LoadState(std::istream& in, bool withBankClock = true);   // throws std::runtime_error on mismatch
+
+    // Material helpers (also used by VacancyBatch for per-lane parameters)
+    static double OxygenSiteDensity_cm3(const Params& p);
+    static uint32_t CapacityPerVoxel(const Params& p, const VoxelGrid& grid);   // throws if Count is too narrow
+    static double InitialLambda(const Params& p, const VoxelGrid& grid);   // mean initial vacancies/voxel
+
+    // Initial Poisson field for storage chunk 'chunk' (count voxels, written
+    // with the given stride). The counter-based RNG stream is keyed on
+    // (seed, chunk), so the field does not depend on the order in which
+    // chunks are drawn, nor on the number of threads drawing them. Sparse
+    // fields (lambda < kSparseLambda) skip through empty voxels by geometric
+    // gaps; above kNormalLambda the normal approximation replaces inversion.
+    static void DrawInitialChunk(uint64_t seed, double lambda, uint32_t cap,
+                                 size_t chunk, Count* out, size_t count, size_t stride = 1);
+    static constexpr double kSparseLambda = 0.25;
+    static constexpr double kNormalLambda = 256.0;
+    // Zero the padding entries of a drawn chunk (layouts that pad the grid)
+    static void ClearPadding(const VoxelLayout& layout, size_t chunk, Count* out, size_t count,
+                             size_t stride = 1);
+    static constexpr size_t kInitChunk = ChunkedArray<Count>::kChunk;
+
+    // Contiguous state in storage order ((Nx,Ny,Nz) under the row-major layout)
+    // for zero-copy views (Python bindings) and the KMC: switches to dense
+    // storage, which stays in place across ResetAndInit() until the next
+    // ConfigureFromGrid(). Banks are in eV only without VoxelStorage::kFixedBank,
+    // and are as of their last touch (not relaxed to the current event).
+    Count* DenseVacCount() { return fVacCount.Densify(); }
+    Bank* DenseEbank() { return fEbank_eV.Densify(); }
+
+    // Read-only per-voxel state (sparse; use ForEachChunk for full sweeps)
+    const ChunkedArray<Count>& VacCounts() const { return fVacCount; }
+
+    size_t MemoryBytes() const {
+        return fVacCount.MemoryBytes() + fEbank_eV.MemoryBytes() + fBankStamp.MemoryBytes() +
+               fNbr.MemoryBytes() + fPerc.MemoryBytes();
+    }
+
 private:
     // internal helpers
-    bool IsInBounds(int ix, int iy, int iz) const;
     size_t Flatten(int ix, int iy, int iz) const;
     void Unflatten(size_t flat, int& ix, int& iy, int& iz) const;
 
-    bool HasVacancyNeighbor6(int ix, int iy, int iz) const;
-    bool IsNeighborOfSeed6(int ix, int iy, int iz) const;
+    uint8_t& NeighborByte(size_t flat);   // probes the neighbours on first use
+    void AdjustNeighbors(size_t flat, int delta);
 
-    double OxygenSiteDensity_cm3() const;
-    uint32_t CapacityPerVoxel(const VoxelGrid& grid) const;
+    // Bank relaxation (Params.bankRelaxEvents): decay factor over dt events,
+    // and a bank as of the current event in eV given its stamp
+    double BankDecayFactor(uint32_t dt) const { return dt ? std::exp(-(double)dt * fBankInvTau) : 1.0; }
+    double BankNow_eV(Bank b, uint32_t stamp) const {
+        const double e = VoxelStorage::BankEV(b);
+        return fBankRelax ? e * BankDecayFactor(fBankClock - stamp) : e;
+    }
 
 private:
     Params fP;
 
     int fNx{0}, fNy{0}, fNz{0};
+    VoxelLayout fLayout;
     int fSeedIx{0}, fSeedIy{0}, fSeedIz{0};
     size_t fSeedFlat{0};
 
-    // stage-2 state:
-    std::vector<uint32_t> fVacCount; // number of vacancies in voxel (0..cap)
+    // stage-2 state (sparse: chunks allocated where the beam reaches):
+    ChunkedArray<Count> fVacCount;   // number of vacancies in voxel (0..cap)
     uint32_t fCapPerVoxel{0};
 
-    // energy bank:
-    std::vector<float> fEbank_eV;
+    // energy bank (VoxelStorage::BankAdd / BankSub / BankEV):
+    ChunkedArray<Bank> fEbank_eV;
+
+    // Bank relaxation: events processed since ResetAndInit (mod 2^32) and,
+    // per voxel, the event of its last bank update; only written with
+    // Params.bankRelaxEvents > 0
+    bool fBankRelax{false};
+    double fBankInvTau{0.0};
+    uint32_t fBankClock{0};
+    ChunkedArray<uint32_t> fBankStamp;
+
+    // Per voxel: number of face neighbours holding a vacancy (bits 0-2) and
+    // whether it is a face neighbour of the seed (bit 3). Probed once on
+    // first use (kNbrUnknown until then) and kept current on every 0 <-> 1
+    // transition afterwards; unknown entries need no updates.
+    static constexpr uint8_t kNbrCountMask = 0x07;
+    static constexpr uint8_t kSeedNbrBit = 0x08;
+    static constexpr uint8_t kNbrUnknown = 0xFF;
+    static constexpr size_t kNbrChunk = ChunkedArray<uint8_t>::kChunk;
+    ChunkedArray<uint8_t> fNbr;
+    size_t fSeedNbr[6];
+    int fSeedNbrCount{0};
+
+    // ProcessEvent scratch: touched-voxel slots and state for the eligibility pass
+    std::vector<Count*> fTouchVacRef;
+    std::vector<Bank*> fTouchBankRef;
+    std::vector<uint8_t*> fTouchNbrRef;
+    std::vector<uint32_t> fTouchVac;
+    std::vector<double> fTouchBank_eV;
+    std::vector<uint8_t> fTouchNbr, fTouchCand;
 
     int fSeedCapturedElectrons{0}; // 0..2
     long long fTotalCreated{0};
 
-    std::mt19937_64 fRng;
+    PercolationTracker fPerc;
+    bool fPercStale{false};     // voxels were emptied since the last rebuild
+    bool fPercUnknown{false};   // counts changed wholesale since the last rebuild
+    bool fPercolated{false};
+    long long fPercolationEvent{-1};
 };
@@ -5,60 +5,102 @@
 #include <cmath>
 #include <stdexcept>
 #include <algorithm>
+#include <utility>
 
-#include "G4ThreeVector.hh"
-#include "G4SystemOfUnits.hh"
+#include "CoreUnits.hh"
+#include "EventRecord.hh"
+#include "ChunkedArray.hh"
+#include "EventAccumulator.hh"
+#include "NpyWriter.hh"
+#include "VoxelLayout.hh"
+#include "VoxelStorage.hh"
 
 class VoxelGrid {
 public:
     struct Index3 { int ix, iy, iz; };
 
-    void Configure(const G4ThreeVector& minCorner,
-                                 const G4ThreeVector& maxCorner,
-                                 G4double dx, G4double dy, G4double dz)
+    // Lengths in Geant4 internal units (mm); see CoreUnits.hh
+    void Configure(const Vec3& minCorner,
+                                 const Vec3& maxCorner,
+                                 double dx, double dy, double dz)
+    {
+        const auto size = maxCorner - minCorner;
+        Build(minCorner, maxCorner, (int)std::ceil(size.x() / dx), (int)std::ceil(size.y() / dy),
+              (int)std::ceil(size.z() / dz), dx, dy, dz);
+    }
+
+    // Known voxel counts (e.g. from a trace header): recomputing them from the
+    // corners can round up by one voxel
+    void Configure(const Vec3& minCorner, int nx, int ny, int nz, double dx, double dy, double dz) {
+        Build(minCorner, minCorner + Vec3(nx * dx, ny * dy, nz * dz), nx, ny, nz, dx, dy, dz);
+    }
+
+private:
+    void Build(const Vec3& minCorner, const Vec3& maxCorner, int nx, int ny, int nz,
+               double dx, double dy, double dz)
     {
         fMin = minCorner;
         fMax = maxCorner;
         fDx = dx; fDy = dy; fDz = dz;
-
-        const auto size = fMax - fMin;
-        fNx = (int)std::ceil(size.x() / fDx);
-        fNy = (int)std::ceil(size.y() / fDy);
-        fNz = (int)std::ceil(size.z() / fDz);
+        fNx = nx; fNy = ny; fNz = nz;
 
         if (fNx <= 0 || fNy <= 0 || fNz <= 0) {
             throw std::runtime_error("VoxelGrid: invalid dimensions.");
         }
 
-        const size_t n = (size_t)fNx * (size_t)fNy * (size_t)fNz;
-        fEdepRun.assign(n, 0.0);
-        fEdepEvent.assign(n, 0.0);
-        fTouchedFlag.assign(n, 0);
-        fHasSeedVacancy.assign(n, 0);
+        // Run accumulators only; per-event scratch lives in thread-local copies
+        // (see ConfigureEventAccumulators), filled by SteppingAction on each worker.
+        // Storage is chunked and allocated on first touch, so memory follows
+        // the beam footprint rather than the pad volume.
+        fLayout.Configure(fNx, fNy, fNz);
+        fEdepRun.Configure(fLayout.Size(), 0);
+        fEdepRunC.Configure(VoxelStorage::kKahanRun ? fLayout.Size() : 0, 0);
+        ResetEventAccumulators();
 
         SetSeedVacancyAtCenter();
     }
 
+public:
+    // Thread-local event grid: same geometry as 'shape', event accumulators
+    // only. Those are sized by the event, not by the grid.
+    void ConfigureEventAccumulators(const VoxelGrid& shape) {
+        fMin = shape.fMin;
+        fMax = shape.fMax;
+        fDx = shape.fDx; fDy = shape.fDy; fDz = shape.fDz;
+        fNx = shape.fNx; fNy = shape.fNy; fNz = shape.fNz;
+        fLayout = shape.fLayout;
+        fSeed = shape.fSeed;
+
+        fEdepRun.Configure(0, 0);
+        fEdepRunC.Configure(0, 0);
+        ResetEventAccumulators();
+    }
+
+    bool SameShape(const VoxelGrid& o) const {
+        return fNx == o.fNx && fNy == o.fNy && fNz == o.fNz &&
+               fDx == o.fDx && fDy == o.fDy && fDz == o.fDz &&
+               fMin == o.fMin;
+    }
+
     // Event accumulators
     void ResetEventAccumulators() {
-        for (size_t flat : fTouched) {
-            fEdepEvent[flat] = 0.0;
-            fTouchedFlag[flat] = 0;
-        }
-        fTouched.clear();
+        // buffers keep their capacity: the next event is of similar size
+        fStepX.clear(); fStepY.clear(); fStepZ.clear(); fStepE.clear();
+        fEvent.Clear();
     }
 
     void ResetRunAccumulators() {
-        std::fill(fEdepRun.begin(), fEdepRun.end(), 0.0);
+        fEdepRun.Reset();
+        fEdepRunC.Reset();
     }
 
-    inline bool Contains(const G4ThreeVector& p) const {
+    inline bool Contains(const Vec3& p) const {
         return (p.x() >= fMin.x() && p.x() < fMax.x() &&
                         p.y() >= fMin.y() && p.y() < fMax.y() &&
                         p.z() >= fMin.z() && p.z() < fMax.z());
     }
 
-    inline Index3 ToIndex(const G4ThreeVector& p) const {
+    inline Index3 ToIndex(const Vec3& p) const {
         Index3 idx;
         idx.ix = (int)std::floor((p.x() - fMin.x()) / fDx);
         idx.iy = (int)std::floor((p.y() - fMin.y()) / fDy);
@@ -69,50 +111,205 @@ public:
         return idx;
     }
 
+    // Flat index in the compile-time storage layout (VoxelLayout.hh)
     inline size_t Flatten(const Index3& idx) const {
-        return (size_t)idx.iz + (size_t)fNz * ((size_t)idx.iy + (size_t)fNy * (size_t)idx.ix);
+        return fLayout.Flatten(idx.ix, idx.iy, idx.iz);
     }
 
     inline Index3 Unflatten(size_t flat) const {
-        const size_t yz = (size_t)fNy * (size_t)fNz;
         Index3 idx;
-        idx.ix = (int)(flat / yz);
-        const size_t rem = flat - (size_t)idx.ix * yz;
-        idx.iy = (int)(rem / (size_t)fNz);
-        idx.iz = (int)(rem - (size_t)idx.iy * (size_t)fNz);
+        fLayout.Unflatten(flat, idx.ix, idx.iy, idx.iz);
         return idx;
     }
 
-    void AddEdep(const G4ThreeVector& p, G4double edep) {
+    const VoxelLayout& Layout() const { return fLayout; }
+
+    // Per-step scoring only appends to a structure-of-arrays buffer; the
+    // buffer is binned into the sparse event sum in one pass at end of event
+    // (BinSteps). 'weight' is the track's statistical weight (Russian roulette
+    // survivors count for several tracks); the event record and the vacancy
+    // energy bank then see the weighted deposit.
+    void AddEdep(const Vec3& p, double edep, double weight = 1.0) {
+        if (edep <= 0.0) return;
+        fStepX.push_back(p.x());
+        fStepY.push_back(p.y());
+        fStepZ.push_back(p.z());
+        fStepE.push_back(edep * weight);
+    }
+
+    // Exact alternative to AddEdep(midpoint): walk the segment a -> b through
+    // the voxels with a 3D-DDA (Amanatides & Woo) and split edep by the path
+    // length in each voxel. The part of the segment inside the grid carries
+    // the whole deposit; a degenerate or outside segment falls back to the
+    // voxel of its midpoint. Goes straight into the event sum (pending
+    // AddEdep steps are binned first, so the step order is kept).
+    void AddSegment(const Vec3& a, const Vec3& b, double edep, double weight = 1.0) {
         if (edep <= 0.0) return;
-        if (!Contains(p)) return;
+        if (!fStepE.empty()) BinSteps();
+        const double e = edep * weight;
+
+        // Clip to the grid box: a + t (b - a), t in [t0, t1]
+        const double pa[3] = {a.x(), a.y(), a.z()};
+        const double d[3] = {b.x() - a.x(), b.y() - a.y(), b.z() - a.z()};
+        const double lo[3] = {fMin.x(), fMin.y(), fMin.z()};
+        const double hi[3] = {fMax.x(), fMax.y(), fMax.z()};
+        double t0 = 0.0, t1 = 1.0;
+        for (int k = 0; k < 3 && t0 < t1; ++k) {
+            if (d[k] == 0.0) {
+                if (pa[k] < lo[k] || pa[k] > hi[k]) t1 = t0;
+                continue;
+            }
+            double ta = (lo[k] - pa[k]) / d[k], tb = (hi[k] - pa[k]) / d[k];
+            if (ta > tb) std::swap(ta, tb);
+            t0 = std::max(t0, ta);
+            t1 = std::min(t1, tb);
+        }
+        if (!(t0 < t1)) {
+            const Vec3 mid = 0.5 * (a + b);
+            if (Contains(mid)) fEvent.Add(Flatten(ToIndex(mid)), e);
+            return;
+        }
 
-        const auto idx = ToIndex(p);
-        const size_t flat = Flatten(idx);
+        // Start at the entry point, clamped into range
+        const double cell[3] = {fDx, fDy, fDz};
+        const int n[3] = {fNx, fNy, fNz};
+        int i[3], step[3];
+        double tMax[3], tDelta[3];
+        for (int k = 0; k < 3; ++k) {
+            const double p = pa[k] + d[k] * t0;
+            i[k] = std::max(0, std::min(n[k] - 1, (int)std::floor((p - lo[k]) / cell[k])));
+            if (d[k] > 0.0) {
+                step[k] = 1;
+                tMax[k] = (lo[k] + (i[k] + 1) * cell[k] - pa[k]) / d[k];
+                tDelta[k] = cell[k] / d[k];
+            } else if (d[k] < 0.0) {
+                step[k] = -1;
+                tMax[k] = (lo[k] + i[k] * cell[k] - pa[k]) / d[k];
+                tDelta[k] = -cell[k] / d[k];
+            } else {
+                step[k] = 0;
+                tMax[k] = tDelta[k] = HUGE_VAL;
+            }
+        }
 
-        fEdepRun[flat] += edep;
-        fEdepEvent[flat] += edep;
+        // A point exactly on a face may start one voxel early: its first
+        // piece then has zero length and is skipped. The last voxel takes the
+        // rest of the segment, so the pieces add up to edep.
+        const double perT = e / (t1 - t0);
+        double t = t0;
+        while (true) {
+            const int k = (tMax[0] < tMax[1]) ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+            const int next = i[k] + step[k];
+            const bool last = tMax[k] >= t1 || next < 0 || next >= n[k];
+            const double tNext = last ? t1 : tMax[k];
+            if (tNext > t) fEvent.Add(Flatten(Index3{i[0], i[1], i[2]}), (tNext - t) * perT);
+            if (last) break;
+            t = tNext;
+            i[k] = next;
+            tMax[k] += tDelta[k];
+        }
+    }
 
-        if (!fTouchedFlag[flat]) {
-            fTouchedFlag[flat] = 1;
-            fTouched.push_back(flat);
+    // Fold the buffered steps into the event sum, in step order (so voxel
+    // totals and first-touch order match direct accumulation). The index
+    // pass has no dependencies between steps and vectorizes; steps outside
+    // the grid get kOutside.
+    void BinSteps() {
+        const size_t n = fStepE.size();
+        fStepFlat.resize(n);
+        const double x0 = fMin.x(), y0 = fMin.y(), z0 = fMin.z();
+        const double x1 = fMax.x(), y1 = fMax.y(), z1 = fMax.z();
+        const double* xs = fStepX.data();
+        const double* ys = fStepY.data();
+        const double* zs = fStepZ.data();
+        size_t* flat = fStepFlat.data();
+        #pragma omp simd
+        for (size_t k = 0; k < n; ++k) {
+            const double x = xs[k], y = ys[k], z = zs[k];
+            const bool inside = x >= x0 && x < x1 && y >= y0 && y < y1 && z >= z0 && z < z1;
+            const int ix = std::max(0, std::min(fNx - 1, (int)std::floor((x - x0) / fDx)));
+            const int iy = std::max(0, std::min(fNy - 1, (int)std::floor((y - y0) / fDy)));
+            const int iz = std::max(0, std::min(fNz - 1, (int)std::floor((z - z0) / fDz)));
+            flat[k] = inside ? fLayout.Flatten(ix, iy, iz) : kOutside;
+        }
+        for (size_t k = 0; k < n; ++k) {
+            if (flat[k] != kOutside) fEvent.Add(flat[k], fStepE[k]);
         }
+        fStepX.clear(); fStepY.clear(); fStepZ.clear(); fStepE.clear();
     }
 
     void SetSeedVacancyAtCenter() {
         if (fNx<=0 || fNy<=0 || fNz<=0) return;
         Index3 c{fNx/2, fNy/2, fNz/2};
         fSeed = c;
-        std::fill(fHasSeedVacancy.begin(), fHasSeedVacancy.end(), 0);
-        fHasSeedVacancy[Flatten(c)] = 1;
+        fSeedFlat = Flatten(c);
     }
 
     Index3 GetSeedIndex() const { return fSeed; }
 
-    const std::vector<size_t>& GetTouchedVoxels() const { return fTouched; }
+    // Voxels touched so far this event, in first-touch order (bins pending steps)
+    const std::vector<size_t>& GetTouchedVoxels() {
+        BinSteps();
+        return fEvent.Keys();
+    }
+
+    // Copy this event's sparse deposition out of the event accumulators.
+    void FillEventRecord(EventRecord& rec) {
+        BinSteps();
+        const auto& keys = fEvent.Keys();
+        const auto& vals = fEvent.Values();
+        rec.flat.assign(keys.begin(), keys.end());
+        rec.edep_eV.resize(keys.size());
+        for (size_t k = 0; k < keys.size(); ++k) {
+            rec.edep_eV[k] = vals[k] / hfo2units::eV;
+        }
+    }
+
+    // Fold one committed event into the run accumulators.
+    void AddEventToRun(const EventRecord& rec) {
+        using Run = VoxelStorage::Run;
+        for (size_t k = 0; k < rec.Size(); ++k) {
+            const Run x = (Run)(rec.edep_eV[k] * hfo2units::eV);
+            if (VoxelStorage::kKahanRun) {
+                // Kahan: fEdepRunC holds the rounding error still owed to the sum
+                Run& sum = fEdepRun[rec.flat[k]];
+                Run& c = fEdepRunC[rec.flat[k]];
+                const Run y = x - c;
+                const Run t = sum + y;
+                c = (t - sum) - y;
+                sum = t;
+            } else {
+                fEdepRun[rec.flat[k]] += x;
+            }
+        }
+    }
+
+    double GetEdepRun_eV(size_t flat) const { return RunValue(flat) / hfo2units::eV; }
+
+    // Contiguous run deposit in Geant4 energy units (VoxelStorage::Run, without
+    // the Kahan term) in storage order ((Nx,Ny,Nz) under the row-major layout),
+    // for zero-copy views (Python bindings). Switches the accumulator to dense
+    // storage; the pointer stays valid until the next Configure().
+    VoxelStorage::Run* DenseEdepRun() { return fEdepRun.Densify(); }
 
-    double GetEdepEvent_eV(size_t flat) const { return fEdepEvent[flat] / eV; }
-    double GetEdepRun_eV(size_t flat) const { return fEdepRun[flat] / eV; }
+    // Run accumulators for checkpoints (allocated chunks only)
+    void SaveRunState(std::ostream& out) const {
+        fEdepRun.Save(out);
+        if (VoxelStorage::kKahanRun) fEdepRunC.Save(out);
+    }
+    void LoadRunState(std::istream& in) {
+        fEdepRun.Reset();
+        fEdepRun.Load(in);
+        fEdepRunC.Reset();
+        if (VoxelStorage::kKahanRun) fEdepRunC.Load(in);
+    }
+
+    // Bytes held by the (sparse) accumulators
+    size_t MemoryBytes() const {
+        return fEdepRun.MemoryBytes() + fEdepRunC.MemoryBytes() + fEvent.MemoryBytes() +
+               (fStepX.capacity() + fStepY.capacity() + fStepZ.capacity() + fStepE.capacity()) * sizeof(double) +
+               fStepFlat.capacity() * sizeof(size_t);
+    }
 
     void ExportEdepCSV(const std::string& path) const {
         std::ofstream out(path);
@@ -124,32 +321,108 @@ public:
                     const auto flat = Flatten(idx);
                     out << ix << "," << iy << "," << iz << ","
                             << GetEdepRun_eV(flat) << ","
-                            << (int)fHasSeedVacancy[flat] << "\n";
+                            << ((flat == fSeedFlat) ? 1 : 0) << "\n";
                 }
             }
         }
     }
 
+    // Binary export: (Nx,Ny,Nz) float64 array of edepRun in eV, logical (ix,iy,iz) order
+    void ExportEdepNpy(const std::string& path) const {
+        NpyWriter out;
+        if (!out.Open(path, NpyWriter::Descr<double>(), {(size_t)fNx, (size_t)fNy, (size_t)fNz})) return;
+
+        if (!VoxelLayout::kRowMajor) {
+            const auto sum = LogicalOrder(fLayout, fEdepRun, fNx, fNy, fNz);
+            std::vector<double> buf(sum.size());
+            if (VoxelStorage::kKahanRun) {
+                const auto c = LogicalOrder(fLayout, fEdepRunC, fNx, fNy, fNz);
+                for (size_t i = 0; i < buf.size(); ++i) buf[i] = ((double)sum[i] - (double)c[i]) / hfo2units::eV;
+            } else {
+                for (size_t i = 0; i < buf.size(); ++i) buf[i] = (double)sum[i] / hfo2units::eV;
+            }
+            out.Write(buf.data(), buf.size());
+            return;
+        }
+        std::vector<double> buf;
+        fEdepRun.ForEachChunk([&](size_t chunk, const VoxelStorage::Run* data, size_t count) {
+            buf.resize(count);
+            const size_t first = chunk * ChunkedArray<VoxelStorage::Run>::kChunk;
+            for (size_t i = 0; i < count; ++i) {
+                buf[i] = (VoxelStorage::kKahanRun ? RunValue(first + i) : (double)data[i]) / hfo2units::eV;
+            }
+            out.Write(buf.data(), count);
+        });
+    }
+
+    // Sparse binary export of non-zero voxels in logical order: <prefix>_idx.npy
+    // (n,3) int32 and <prefix>_edep_eV.npy (n,) float64. Only allocated chunks
+    // are visited.
+    void ExportEdepNpySparse(const std::string& prefix) const {
+        NpyWriter idxOut, valOut;
+        if (!idxOut.Open(prefix + "_idx.npy", NpyWriter::Descr<int32_t>(), {0, 3}) ||
+            !valOut.Open(prefix + "_edep_eV.npy", NpyWriter::Descr<double>(), {0})) return;
+
+        // (storage flat, value); storage order is logical order only when row-major
+        std::vector<std::pair<size_t, double>> nonZero;
+        fEdepRun.ForEachAllocated([&](size_t chunk, const VoxelStorage::Run* data, size_t count) {
+            const size_t first = chunk * ChunkedArray<VoxelStorage::Run>::kChunk;
+            for (size_t i = 0; i < count; ++i) {
+                if (data[i] != 0) nonZero.emplace_back(first + i, RunValue(first + i) / hfo2units::eV);
+            }
+        });
+        if (!VoxelLayout::kRowMajor) {
+            RowMajorLayout rm;
+            rm.Configure(fNx, fNy, fNz);
+            auto logical = [&](size_t flat) {
+                const auto idx = Unflatten(flat);
+                return rm.Flatten(idx.ix, idx.iy, idx.iz);
+            };
+            std::sort(nonZero.begin(), nonZero.end(),
+                      [&](const auto& a, const auto& b) { return logical(a.first) < logical(b.first); });
+        }
+        for (const auto& [flat, v] : nonZero) {
+            const auto idx = Unflatten(flat);
+            const int32_t ijk[3] = {idx.ix, idx.iy, idx.iz};
+            idxOut.Write(ijk, 3);
+            valOut.Write(&v, 1);
+        }
+        idxOut.SetLeadingDim(nonZero.size());
+        valOut.SetLeadingDim(nonZero.size());
+    }
+
     int Nx() const { return fNx; }
     int Ny() const { return fNy; }
     int Nz() const { return fNz; }
-    G4double Dx() const { return fDx; }
-    G4double Dy() const { return fDy; }
-    G4double Dz() const { return fDz; }
+    double Dx() const { return fDx; }
+    double Dy() const { return fDy; }
+    double Dz() const { return fDz; }
 
-    G4ThreeVector Min() const { return fMin; }
-    G4ThreeVector Max() const { return fMax; }
+    Vec3 Min() const { return fMin; }
+    Vec3 Max() const { return fMax; }
 
 private:
-    G4ThreeVector fMin{0,0,0}, fMax{0,0,0};
-    G4double fDx{50*nm}, fDy{50*nm}, fDz{1*nm};
+    Vec3 fMin{0,0,0}, fMax{0,0,0};
+    double fDx{50*hfo2units::nm}, fDy{50*hfo2units::nm}, fDz{1*hfo2units::nm};
     int fNx{0}, fNy{0}, fNz{0};
+    VoxelLayout fLayout;
+
+    // Run deposit in Geant4 energy units, plus its Kahan compensation
+    // (VoxelStorage::kKahanRun only; empty otherwise)
+    ChunkedArray<VoxelStorage::Run> fEdepRun;
+    ChunkedArray<VoxelStorage::Run> fEdepRunC;
+
+    double RunValue(size_t flat) const {
+        if (VoxelStorage::kKahanRun) return (double)fEdepRun.Get(flat) - (double)fEdepRunC.Get(flat);
+        return (double)fEdepRun.Get(flat);
+    }
 
-    std::vector<double> fEdepRun;   // Geant4 energy units
-    std::vector<double> fEdepEvent; // per-event accum
-    std::vector<uint8_t> fTouchedFlag;
-    std::vector<size_t> fTouched;
+    // Per-event scratch: buffered steps (SoA) and their sparse voxel sums
+    static constexpr size_t kOutside = SIZE_MAX;
+    std::vector<double> fStepX, fStepY, fStepZ, fStepE;   // edep weighted
+    std::vector<size_t> fStepFlat;
+    EventAccumulator fEvent;
 
-    std::vector<uint8_t> fHasSeedVacancy;
     Index3 fSeed{0,0,0};
+    size_t fSeedFlat{0};
 };
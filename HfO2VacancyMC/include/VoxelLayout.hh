@@ -0,0 +1,241 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Storage order of the voxel grid: maps (ix,iy,iz) to the flat index used by
+// VoxelGrid, VacancyModel and everything keyed like them (event records,
+// traces, checkpoints, KMC, percolation). Chosen at compile time
+// (-DHFO2_LAYOUT=rowmajor|morton|tiled, see VoxelLayout below); the exporters
+// always write logical (ix,iy,iz) order.
+//
+// Every policy has the same interface:
+//   Configure(nx, ny, nz)
+//   Size()                 storage extent; > nx*ny*nz if the layout pads
+//   Flatten / Unflatten    padding entries unflatten out of range
+//   IsVoxel(flat)          false for padding
+//   Neighbors6(flat, out)  in-range face neighbours, order +x -x +y -y +z -z
+//   kId, kName, kRowMajor  (traces and checkpoints record kId)
+
+// z fastest, then y, then x: the +-x neighbours are Ny*Nz apart.
+class RowMajorLayout {
+public:
+    static constexpr uint32_t kId = 0;
+    static constexpr const char* kName = "rowmajor";
+    static constexpr bool kRowMajor = true;
+
+    void Configure(int nx, int ny, int nz) { fNx = nx; fNy = ny; fNz = nz; }
+
+    size_t Size() const { return (size_t)fNx * (size_t)fNy * (size_t)fNz; }
+    bool IsVoxel(size_t flat) const { return flat < Size(); }
+
+    size_t Flatten(int ix, int iy, int iz) const {
+        return (size_t)iz + (size_t)fNz * ((size_t)iy + (size_t)fNy * (size_t)ix);
+    }
+
+    void Unflatten(size_t flat, int& ix, int& iy, int& iz) const {
+        const size_t yz = (size_t)fNy * (size_t)fNz;
+        ix = (int)(flat / yz);
+        const size_t rem = flat - (size_t)ix * yz;
+        iy = (int)(rem / (size_t)fNz);
+        iz = (int)(rem - (size_t)iy * (size_t)fNz);
+    }
+
+    int Neighbors6(size_t flat, size_t out[6]) const {
+        int ix, iy, iz;
+        Unflatten(flat, ix, iy, iz);
+        const size_t yz = (size_t)fNy * (size_t)fNz;
+        int k = 0;
+        if (ix + 1 < fNx) out[k++] = flat + yz;
+        if (ix > 0)       out[k++] = flat - yz;
+        if (iy + 1 < fNy) out[k++] = flat + fNz;
+        if (iy > 0)       out[k++] = flat - fNz;
+        if (iz + 1 < fNz) out[k++] = flat + 1;
+        if (iz > 0)       out[k++] = flat - 1;
+        return k;
+    }
+
+private:
+    int fNx{0}, fNy{0}, fNz{0};
+};
+
+// Z-order curve: the bits of ix, iy, iz interleaved (z lowest), so a storage
+// chunk of 4096 voxels is a 16^3 brick where the grid is deep enough. Axes
+// with fewer bits drop out of the interleave once exhausted. Per-axis spread
+// tables make Flatten three loads and two ORs; neighbours step on the dilated
+// coordinates without decoding. Pads each axis up to a power of two, which
+// costs index space only: padding is never written.
+class MortonLayout {
+public:
+    static constexpr uint32_t kId = 1;
+    static constexpr const char* kName = "morton";
+    static constexpr bool kRowMajor = false;
+
+    void Configure(int nx, int ny, int nz) {
+        fN[0] = nx; fN[1] = ny; fN[2] = nz;
+        int bits[3];
+        for (int a = 0; a < 3; ++a) {
+            bits[a] = 0;
+            while ((1 << bits[a]) < fN[a]) ++bits[a];
+            fMask[a] = 0;
+        }
+        // Round-robin from the lowest bit: z, y, x
+        int bit = 0;
+        for (int level = 0; level < 32; ++level) {
+            for (int a = 2; a >= 0; --a) {
+                if (level < bits[a]) fMask[a] |= uint64_t(1) << bit++;
+            }
+        }
+        for (int a = 0; a < 3; ++a) {
+            fSpread[a].resize((size_t)std::max(fN[a], 1));
+            for (int i = 0; i < fN[a]; ++i) fSpread[a][(size_t)i] = Deposit((uint64_t)i, fMask[a]);
+        }
+    }
+
+    size_t Size() const {
+        return (size_t)(fSpread[0].back() | fSpread[1].back() | fSpread[2].back()) + 1;
+    }
+
+    bool IsVoxel(size_t flat) const {
+        int ix, iy, iz;
+        Unflatten(flat, ix, iy, iz);
+        return ix < fN[0] && iy < fN[1] && iz < fN[2];
+    }
+
+    size_t Flatten(int ix, int iy, int iz) const {
+        return (size_t)(fSpread[0][(size_t)ix] | fSpread[1][(size_t)iy] | fSpread[2][(size_t)iz]);
+    }
+
+    void Unflatten(size_t flat, int& ix, int& iy, int& iz) const {
+        ix = (int)Extract(flat, fMask[0]);
+        iy = (int)Extract(flat, fMask[1]);
+        iz = (int)Extract(flat, fMask[2]);
+    }
+
+    int Neighbors6(size_t flat, size_t out[6]) const {
+        const uint64_t f = flat;
+        int k = 0;
+        for (int a = 0; a < 3; ++a) {
+            const uint64_t m = fMask[a], c = f & m, rest = f & ~m;
+            if (c != fSpread[a].back()) out[k++] = (size_t)((((c | ~m) + 1) & m) | rest);
+            if (c != 0)                 out[k++] = (size_t)(((c - 1) & m) | rest);
+        }
+        return k;
+    }
+
+private:
+    static uint64_t Deposit(uint64_t v, uint64_t mask) {
+        uint64_t r = 0;
+        for (uint64_t b = 1; mask; b <<= 1, mask &= mask - 1) {
+            if (v & b) r |= mask & (~mask + 1);
+        }
+        return r;
+    }
+
+    static uint64_t Extract(uint64_t v, uint64_t mask) {
+        uint64_t r = 0;
+        for (uint64_t b = 1; mask; b <<= 1, mask &= mask - 1) {
+            if (v & mask & (~mask + 1)) r |= b;
+        }
+        return r;
+    }
+
+    int fN[3]{0, 0, 0};
+    uint64_t fMask[3]{0, 0, 0};
+    std::vector<uint64_t> fSpread[3];
+};
+
+// Bricks of 16 x 16 x min(Nz, 16) voxels (z fastest inside a brick, bricks
+// row-major). For oxides up to 16 layers a brick is a full-depth column
+// block, so the vertical and lateral neighbours of a voxel share a few
+// kilobytes. Pads x, y (and z above 16 layers) to whole bricks.
+class TiledLayout {
+public:
+    static constexpr uint32_t kId = 2;
+    static constexpr const char* kName = "tiled";
+    static constexpr bool kRowMajor = false;
+    static constexpr int kTile = 16;
+
+    void Configure(int nx, int ny, int nz) {
+        fNx = nx; fNy = ny; fNz = nz;
+        fTz = std::min(nz, kTile);
+        fBx = (nx + kTile - 1) / kTile;
+        fBy = (ny + kTile - 1) / kTile;
+        fBz = (nz + fTz - 1) / fTz;
+        fBrick = (size_t)kTile * kTile * (size_t)fTz;
+    }
+
+    size_t Size() const { return (size_t)fBx * (size_t)fBy * (size_t)fBz * fBrick; }
+
+    bool IsVoxel(size_t flat) const {
+        int ix, iy, iz;
+        Unflatten(flat, ix, iy, iz);
+        return ix < fNx && iy < fNy && iz < fNz;
+    }
+
+    size_t Flatten(int ix, int iy, int iz) const {
+        const size_t brick = ((size_t)(ix / kTile) * (size_t)fBy + (size_t)(iy / kTile)) * (size_t)fBz + (size_t)(iz / fTz);
+        const size_t local = ((size_t)(ix % kTile) * kTile + (size_t)(iy % kTile)) * (size_t)fTz + (size_t)(iz % fTz);
+        return brick * fBrick + local;
+    }
+
+    void Unflatten(size_t flat, int& ix, int& iy, int& iz) const {
+        const size_t brick = flat / fBrick, local = flat - brick * fBrick;
+        const int bz = (int)(brick % (size_t)fBz);
+        const size_t col = brick / (size_t)fBz;
+        const int by = (int)(col % (size_t)fBy), bx = (int)(col / (size_t)fBy);
+        const int lz = (int)(local % (size_t)fTz);
+        const size_t lcol = local / (size_t)fTz;
+        ix = bx * kTile + (int)(lcol / kTile);
+        iy = by * kTile + (int)(lcol % kTile);
+        iz = bz * fTz + lz;
+    }
+
+    int Neighbors6(size_t flat, size_t out[6]) const {
+        int ix, iy, iz;
+        Unflatten(flat, ix, iy, iz);
+        int k = 0;
+        if (ix + 1 < fNx) out[k++] = Flatten(ix + 1, iy, iz);
+        if (ix > 0)       out[k++] = Flatten(ix - 1, iy, iz);
+        if (iy + 1 < fNy) out[k++] = Flatten(ix, iy + 1, iz);
+        if (iy > 0)       out[k++] = Flatten(ix, iy - 1, iz);
+        if (iz + 1 < fNz) out[k++] = Flatten(ix, iy, iz + 1);
+        if (iz > 0)       out[k++] = Flatten(ix, iy, iz - 1);
+        return k;
+    }
+
+private:
+    int fNx{0}, fNy{0}, fNz{0};
+    int fTz{1}, fBx{0}, fBy{0}, fBz{0};
+    size_t fBrick{1};
+};
+
+#if defined(HFO2_LAYOUT_MORTON)
+using VoxelLayout = MortonLayout;
+#elif defined(HFO2_LAYOUT_TILED)
+using VoxelLayout = TiledLayout;
+#else
+using VoxelLayout = RowMajorLayout;
+#endif
+
+// Copy of a chunked per-voxel array in logical (ix,iy,iz) row-major order,
+// for exporters under a non-row-major layout. Visits storage chunk by chunk,
+// so lazily initialized chunks are produced once.
+template <class Layout, class Array>
+auto LogicalOrder(const Layout& layout, const Array& a, int nx, int ny, int nz) {
+    using T = std::decay_t<decltype(a.Get(0))>;
+    RowMajorLayout rm;
+    rm.Configure(nx, ny, nz);
+    std::vector<T> out(rm.Size());
+    a.ForEachChunk([&](size_t chunk, const T* data, size_t count) {
+        const size_t first = chunk * Array::kChunk;
+        for (size_t i = 0; i < count; ++i) {
+            int ix, iy, iz;
+            layout.Unflatten(first + i, ix, iy, iz);
+            if (ix < nx && iy < ny && iz < nz) out[rm.Flatten(ix, iy, iz)] = data[i];
+        }
+    });
+    return out;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Value types of the per-voxel run state: vacancy counts and energy banks
+// (VacancyModel, VacancyBatch, the KMC engines) and the run deposit
+// (VoxelGrid). Chosen at compile time like VoxelLayout
+// (-DHFO2_STORAGE=wide|compact|compact8, -DHFO2_KAHAN_RUN=ON, see
+// VoxelStorage below); the exporters write the same dtypes under every policy
+// (uint32 counts, float32 banks, float64 deposits).
+//
+// Every policy has the same interface:
+//   Count                  vacancy count (ConfigureFromGrid throws if the
+//                          voxel capacity does not fit)
+//   Bank                   energy bank, only through BankAdd / BankSub / BankEV (eV)
+//                          and BankDecay (bank relaxation, key: per-voxel dither seed)
+//   Run, kKahanRun         run deposit in Geant4 energy units; with kKahanRun
+//                          VoxelGrid keeps a compensation term per voxel
+//   kBytesPerVoxel         footprint of one touched voxel
+//   kId, kName             (checkpoints record kId)
+
+// 32-bit counts, float banks, double run deposit.
+struct WideStorage {
+    using Count = uint32_t;
+    using Bank = float;
+    using Run = double;
+    static constexpr bool kFixedBank = false;
+    static constexpr bool kKahanRun = false;
+    static constexpr uint32_t kId = 0;
+    static constexpr const char* kName = "wide";
+
+    static Bank BankAdd(Bank b, double eV) { return b + (float)eV; }
+    static Bank BankSub(Bank b, double eV) { return (float)((double)b - eV); }
+    static double BankEV(Bank b) { return (double)b; }
+    static Bank BankDecay(Bank b, double f, uint64_t) { return (float)((double)b * f); }
+
+    static constexpr size_t kBytesPerVoxel = sizeof(Count) + sizeof(Bank) + sizeof(Run);
+};
+
+// Narrow counts, 16-bit fixed-point banks and a float run deposit.
+// Banks count quanta of kBankQuantum_eV: every deposit and activation energy
+// is rounded to the quantum, and a bank saturates at 65535 quanta (2 keV),
+// which only matters once a voxel has banked more than its remaining
+// capacity times Ea. The float run deposit keeps ~7 digits per voxel, or
+// about double precision with the Kahan compensation (4 more bytes).
+// Tolerance against WideStorage: the summary totals (totalCreated,
+// createdPerPrimary) within 1e-4 relative; deposits within 2e-6 relative per
+// voxel (1e-7 with Kahan); exported banks within half a quantum below 2 keV.
+template <class CountT, bool Kahan>
+struct CompactStorage {
+    using Count = CountT;
+    using Bank = uint16_t;
+    using Run = float;
+    static constexpr bool kFixedBank = true;
+    static constexpr bool kKahanRun = Kahan;
+    static constexpr uint32_t kId = (sizeof(CountT) == 1 ? 2u : 1u) | (Kahan ? 4u : 0u);
+    static constexpr const char* kName =
+        sizeof(CountT) == 1 ? (Kahan ? "compact8+kahan" : "compact8") : (Kahan ? "compact+kahan" : "compact");
+
+    static constexpr double kBankQuantum_eV = 1.0 / 32.0;
+    static constexpr double kBankMax = (double)std::numeric_limits<Bank>::max();
+
+    static Bank BankAdd(Bank b, double eV) {
+        const double q = (double)b + std::floor(eV / kBankQuantum_eV + 0.5);
+        return (Bank)(q < kBankMax ? q : kBankMax);
+    }
+    static Bank BankSub(Bank b, double eV) {
+        const double q = (double)b - std::floor(eV / kBankQuantum_eV + 0.5);
+        return (Bank)(q > 0.0 ? q : 0.0);
+    }
+    static double BankEV(Bank b) { return (double)b * kBankQuantum_eV; }
+
+    // Decay rounds up or down at random, with a uniform drawn from a hash of
+    // key, so frequent small decays neither stall nor drain a bank on average
+    static Bank BankDecay(Bank b, double f, uint64_t key) {
+        const double q = (double)b * f;
+        const double lo = std::floor(q);
+        return (Bank)(lo + (Uniform(key) < q - lo ? 1.0 : 0.0));
+    }
+
+    static constexpr size_t kBytesPerVoxel =
+        sizeof(Count) + sizeof(Bank) + sizeof(Run) * (Kahan ? 2 : 1);
+
+private:
+    // splitmix64 finalizer, top 53 bits as [0, 1)
+    static double Uniform(uint64_t z) {
+        z += 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= (z >> 31);
+        return (double)(z >> 11) * 0x1.0p-53;
+    }
+};
+
+#if defined(HFO2_KAHAN_RUN)
+#define HFO2_STORAGE_KAHAN true
+#else
+#define HFO2_STORAGE_KAHAN false
+#endif
+
+#if defined(HFO2_STORAGE_COMPACT8)
+using VoxelStorage = CompactStorage<uint8_t, HFO2_STORAGE_KAHAN>;
+#elif defined(HFO2_STORAGE_COMPACT)
+using VoxelStorage = CompactStorage<uint16_t, HFO2_STORAGE_KAHAN>;
+#else
+using VoxelStorage = WideStorage;
+#endif
+
+#undef HFO2_STORAGE_KAHAN
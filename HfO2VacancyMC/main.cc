@@ -1,4 +1,4 @@
-#include "G4RunManager.hh"
+#include "G4RunManagerFactory.hh"
 #include "G4UImanager.hh"
 
 #include "G4VisExecutive.hh"
@@ -6,34 +6,34 @@
 
 #include "DetectorConstruction.hh"
 #include "ActionInitialization.hh"
+#include "EnsembleRunner.hh"
+#include "PhysicsList.hh"
 
-#include "G4VModularPhysicsList.hh"
-#include "G4EmLivermorePhysics.hh"
-#include "G4EmParameters.hh"
-#include "G4DecayPhysics.hh"
+#include <cstdlib>
 
 int main(int argc, char** argv) {
-    auto runManager = new G4RunManager();
+    // Usage: HfO2VacancyMC [macro] [nThreads]
+    // Default type follows the Geant4 build (MT/tasking if available, G4RUN_MANAGER_TYPE overrides).
+    // Vacancy maps do not depend on the thread count: events are committed in event-ID order.
+    auto runManager = G4RunManagerFactory::CreateRunManager(G4RunManagerType::Default);
+    if (argc > 2) {
+        const int nThreads = std::atoi(argv[2]);
+        if (nThreads > 0) runManager->SetNumberOfThreads(nThreads);
+    }
 
     auto det = new DetectorConstruction();
     runManager->SetUserInitialization(det);
 
-    // Physics list: minimal modular + Livermore EM
-    auto phys = new G4VModularPhysicsList();
-    phys->RegisterPhysics(new G4DecayPhysics());
-    phys->RegisterPhysics(new G4EmLivermorePhysics());
-
-    // Optional: lower edge for cuts (important if you later want more low-energy secondaries)
-    // You can also set via macro: /cuts/setLowEdge 100 eV
-    auto emParams = G4EmParameters::Instance();
-    emParams->SetMinEnergy(100.0*eV);
-    emParams->SetMaxEnergy(100.0*MeV);
-
-    runManager->SetUserInitialization(phys);
+    // Physics list: EM only, low-energy models in HfO2Region (see /phys/).
+    // Lower edge for cuts via macro: /cuts/setLowEdge 100 eV
+    runManager->SetUserInitialization(new PhysicsList());
     runManager->SetUserInitialization(new ActionInitialization(det));
 
     // runManager->Initialize();
 
+    // /ensemble/ commands: forked realizations for breakdown statistics
+    EnsembleRunner ensemble(runManager);
+
     // UI
     auto UImanager = G4UImanager::GetUIpointer();
     if (argc == 1) {
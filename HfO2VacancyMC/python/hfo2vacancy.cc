@@ -0,0 +1,201 @@
+// Python bindings for the vacancy stage (pybind11).
+//
+// The per-voxel state is exposed as NumPy views of shape (Nx, Ny, Nz) over the
+// C++ buffers, so no data is copied:
+//   VoxelGrid.edep_run_MeV   float64, run deposit in Geant4 units (MeV)
+//   VacancyModel.vac_count   uint32
+//   VacancyModel.ebank_eV    float32 (as of each voxel's last touch with
+//                            params.bankRelaxEvents; export_npy decays them)
+// (dtypes of the default -DHFO2_STORAGE=wide; the compact storage gives
+// float32 deposits without the Kahan term and uint16/uint8 counts, and has
+// no ebank_eV view since its banks are fixed point)
+// Taking a view switches that field to dense storage; views stay valid across
+// reset_and_init()/reset_run() and are invalidated by configure*(). Call
+// counts_changed() after writing into vac_count. Views need
+// the row-major storage layout (the default -DHFO2_LAYOUT=rowmajor); flat
+// indices are always VoxelGrid.flatten(ix, iy, iz).
+//
+//   import hfo2vacancy as hv
+//   g = hv.VoxelGrid(); g.configure((-500,-500,-5), (500,500,0), (50,50,1))
+//   m = hv.VacancyModel(); m.params.initConc_cm3 = 1e20; m.configure_from_grid(g)
+//   m.process_events(offsets, flat, edep_eV, grid=g)   # CSR batch of events
+//   vac = m.vac_count                                  # live (Nx,Ny,Nz) view
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <array>
+#include <stdexcept>
+#include <string>
+
+#include "VoxelGrid.hh"
+#include "VacancyModel.hh"
+#include "EventRecord.hh"
+
+namespace py = pybind11;
+
+using Triple = std::array<double, 3>;
+using hfo2units::nm;
+
+template <class T>
+static py::array_t<T> VoxelView(T* data, int nx, int ny, int nz, py::handle owner) {
+    if (!VoxelLayout::kRowMajor) {
+        throw std::runtime_error(std::string("zero-copy views need the row-major layout; this build uses ") +
+                                 VoxelLayout::kName + " (use the npy exports)");
+    }
+    const py::ssize_t s = (py::ssize_t)sizeof(T);
+    return py::array_t<T>({(py::ssize_t)nx, (py::ssize_t)ny, (py::ssize_t)nz},
+                          {s * ny * nz, s * nz, s},
+                          data, owner);
+}
+
+using IndexArray = py::array_t<uint64_t, py::array::c_style | py::array::forcecast>;
+using ValueArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+// Events given in CSR form: event e covers flat[offsets[e] .. offsets[e+1]).
+// Each event is applied as EventCommitter does: run grid first, then the model.
+static void ProcessEvents(VacancyModel& model, const IndexArray& offsets, const IndexArray& flat,
+                          const ValueArray& edep_eV, VoxelGrid* grid) {
+    if (offsets.ndim() != 1 || flat.ndim() != 1 || edep_eV.ndim() != 1) {
+        throw std::runtime_error("process_events: expected 1D arrays");
+    }
+    if (flat.size() != edep_eV.size()) {
+        throw std::runtime_error("process_events: flat and edep_eV differ in length");
+    }
+
+    if (grid && (grid->Nx() != model.Nx() || grid->Ny() != model.Ny() || grid->Nz() != model.Nz())) {
+        throw std::runtime_error("process_events: grid and model shapes differ");
+    }
+
+    const uint64_t* off = offsets.data();
+    const uint64_t* idx = flat.data();
+    const double* val = edep_eV.data();
+    const size_t nEvents = offsets.size() > 0 ? (size_t)offsets.size() - 1 : 0;
+
+    for (size_t e = 0; e < nEvents; ++e) {
+        if (off[e] > off[e + 1] || off[e + 1] > (uint64_t)flat.size()) {
+            throw std::runtime_error("process_events: offsets must be non-decreasing and within flat");
+        }
+    }
+    for (py::ssize_t k = 0; k < flat.size(); ++k) {
+        if (!model.Layout().IsVoxel(idx[k])) throw std::runtime_error("process_events: flat index out of range");
+    }
+
+    py::gil_scoped_release release;
+    EventRecord rec;
+    for (size_t e = 0; e < nEvents; ++e) {
+        rec.Clear();
+        rec.eventId = (long long)e;
+        rec.flat.assign(idx + off[e], idx + off[e + 1]);
+        rec.edep_eV.assign(val + off[e], val + off[e + 1]);
+        if (grid) grid->AddEventToRun(rec);
+        model.ProcessEvent(rec);
+        if (model.StopRequested()) break;
+    }
+}
+
+PYBIND11_MODULE(hfo2vacancy, m) {
+    m.doc() = "HfO2 vacancy-stage model with zero-copy NumPy views of the voxel state";
+
+    py::class_<VoxelGrid>(m, "VoxelGrid")
+        .def(py::init<>())
+        .def("configure",
+             [](VoxelGrid& g, const Triple& min_nm, const Triple& max_nm, const Triple& d_nm) {
+                 g.Configure(Vec3(min_nm[0], min_nm[1], min_nm[2]) * nm,
+                             Vec3(max_nm[0], max_nm[1], max_nm[2]) * nm,
+                             d_nm[0] * nm, d_nm[1] * nm, d_nm[2] * nm);
+             },
+             py::arg("min_nm"), py::arg("max_nm"), py::arg("d_nm"),
+             "Set the pad bounds and voxel pitch (nm); drops all run state")
+        .def("reset_run", &VoxelGrid::ResetRunAccumulators)
+        .def_property_readonly("shape", [](const VoxelGrid& g) {
+            return py::make_tuple(g.Nx(), g.Ny(), g.Nz());
+        })
+        .def_property_readonly("d_nm", [](const VoxelGrid& g) {
+            return py::make_tuple(g.Dx() / nm, g.Dy() / nm, g.Dz() / nm);
+        })
+        .def("flatten", [](const VoxelGrid& g, int ix, int iy, int iz) {
+                 if (ix < 0 || ix >= g.Nx() || iy < 0 || iy >= g.Ny() || iz < 0 || iz >= g.Nz()) {
+                     throw py::index_error("flatten: voxel index out of range");
+                 }
+                 return g.Flatten(VoxelGrid::Index3{ix, iy, iz});
+             },
+             py::arg("ix"), py::arg("iy"), py::arg("iz"), "Flat index in the storage layout of this build")
+        .def_property_readonly_static("layout", [](py::object) { return std::string(VoxelLayout::kName); })
+        .def_property_readonly_static("storage", [](py::object) { return std::string(VoxelStorage::kName); })
+        .def_property_readonly("seed_index", [](const VoxelGrid& g) {
+            const auto s = g.GetSeedIndex();
+            return py::make_tuple(s.ix, s.iy, s.iz);
+        })
+        .def_property_readonly("edep_run_MeV", [](py::object self) {
+            auto& g = self.cast<VoxelGrid&>();
+            return VoxelView(g.DenseEdepRun(), g.Nx(), g.Ny(), g.Nz(), self);
+        })
+        .def("memory_bytes", &VoxelGrid::MemoryBytes)
+        .def("export_edep_npy", &VoxelGrid::ExportEdepNpy, py::arg("path"));
+
+    using P = VacancyModel::Params;
+    py::class_<P>(m, "VacancyParams")
+        .def(py::init<>())
+        .def_readwrite("W_eV", &P::W_eV)
+        .def_readwrite("Ea_base_eV", &P::Ea_base_eV)
+        .def_readwrite("Ea_fast_eV", &P::Ea_fast_eV)
+        .def_readwrite("fastOnlyNearSeed", &P::fastOnlyNearSeed)
+        .def_readwrite("bankRelaxEvents", &P::bankRelaxEvents)
+        .def_readwrite("initConc_cm3", &P::initConc_cm3)
+        .def_readwrite("initSeed", &P::initSeed)
+        .def_readwrite("rho_g_cm3", &P::rho_g_cm3)
+        .def_readwrite("molarMass_g_mol", &P::molarMass_g_mol)
+        .def_readwrite("trackPercolation", &P::trackPercolation)
+        .def_readwrite("stopOnPercolation", &P::stopOnPercolation);
+
+    py::class_<VacancyModel>(m, "VacancyModel")
+        .def(py::init<>())
+        .def(py::init([](const P& p) {
+            VacancyModel model;
+            model.GetParams() = p;
+            return model;
+        }), py::arg("params"))
+        .def_property("params",
+                      [](VacancyModel& model) -> P& { return model.GetParams(); },
+                      [](VacancyModel& model, const P& p) { model.GetParams() = p; },
+                      py::return_value_policy::reference_internal)
+        .def("configure_from_grid", &VacancyModel::ConfigureFromGrid, py::arg("grid"))
+        .def("reset_and_init", &VacancyModel::ResetAndInit, py::arg("grid"))
+        .def("process_event",
+             [](VacancyModel& model, const IndexArray& flat, const ValueArray& edep_eV, VoxelGrid* grid) {
+                 const uint64_t offsets[2] = {0, (uint64_t)flat.size()};
+                 ProcessEvents(model, IndexArray(2, offsets), flat, edep_eV, grid);
+             },
+             py::arg("flat"), py::arg("edep_eV"), py::arg("grid") = nullptr)
+        .def("process_events", &ProcessEvents,
+             py::arg("offsets"), py::arg("flat"), py::arg("edep_eV"), py::arg("grid") = nullptr,
+             "Apply a CSR batch of events in order (grid, if given, accumulates edep)")
+        .def_property_readonly("total_created", &VacancyModel::TotalCreated)
+        .def_property_readonly("seed_captured_electrons", &VacancyModel::SeedCapturedElectrons)
+        .def_property_readonly("percolated", &VacancyModel::Percolated)
+        .def_property_readonly("percolation_event", &VacancyModel::PercolationEvent)
+        .def("rebuild_percolation", &VacancyModel::RebuildPercolation)
+        .def("counts_changed", &VacancyModel::CountsChanged,
+             "Rebuild the neighbour field after vac_count was modified in place")
+        .def_property_readonly("shape", [](const VacancyModel& model) {
+            return py::make_tuple(model.Nx(), model.Ny(), model.Nz());
+        })
+        .def_property_readonly("vac_count", [](py::object self) {
+            auto& model = self.cast<VacancyModel&>();
+            return VoxelView(model.DenseVacCount(), model.Nx(), model.Ny(), model.Nz(), self);
+        })
+        .def_property_readonly("ebank_eV", [](py::object self) {
+            auto& model = self.cast<VacancyModel&>();
+            if (VoxelStorage::kFixedBank) {
+                throw std::runtime_error(std::string("ebank_eV needs float banks; this build uses ") +
+                                         VoxelStorage::kName + " storage (use export_npy)");
+            }
+            return VoxelView(model.DenseEbank(), model.Nx(), model.Ny(), model.Nz(), self);
+        })
+        .def("memory_bytes", &VacancyModel::MemoryBytes)
+        .def("export_summary_csv", &VacancyModel::ExportSummaryCSV,
+             py::arg("path"), py::arg("nPrimaries"))
+        .def("export_npy", &VacancyModel::ExportVacancyNpy, py::arg("prefix"));
+}
@@ -0,0 +1,322 @@
+// Standalone vacancy-stage replay: drives VacancyModel from a deposition trace
+// written with /trace/file, without starting the Geant4 kernel.
+//
+// Usage: HfO2VacancyReplay <trace.bin> [key=value ...]
+//   W_eV, Ea_base_eV, Ea_fast_eV, fastOnlyNearSeed (0/1), bankRelaxEvents,
+//   vacConcCm3, vacSeed, hfo2Rho_g_cm3, trackPercolation (0/1),
+//   stopOnPercolation (0/1)  -- as the /det/ commands
+//   summary=<csv>  (default replay_summary.csv)
+//   map=<csv>      (optional full vacancy map)
+//   npy=<prefix>   (optional binary maps: <prefix>_vacCount.npy, _Ebank_eV.npy, _edep.npy)
+//   kmcTemperatureK, kmcAttemptHz, kmcEd_eV, kmcEg_eV, kmcEr_eV, kmcGenDipole_eA,
+//   kmcSeed, kmcDtPerEvent_s, kmcPostTime_s, kmcThreads, kmcSectorX, kmcSectorY,
+//   kmcWindow_s, kmcMaxDense_MiB  -- as the /kmc/ commands (vacancy kinetics)
+//   field=1, fieldEvery=<n>, Vtop, Vbottom, epsOxide, epsDefect  -- potential
+//                  solve at the end and, with fieldEvery, every n events as in
+//                  a run (the KMC sees each refresh n events later);
+//                  potential=<npy> writes it
+//   tat=1, tatCutoffNm, tatTrapDepth_eV, tatBarrier_eV, tatMEff  -- trap-assisted
+//                  tunnelling current at the end (as the /tat/ commands)
+//   checkpoint=<file>, checkpointEvery=<n>  -- write a checkpoint every n events
+//                  and at the end; restart=<file> continues from one, skipping
+//                  the trace events it already holds; maxEvents=<n> stops early
+//   lanes=<csv>    parameter sweep in one pass (VacancyBatch): header row of the
+//                  keys above, one parameter set per row; unset keys keep the
+//                  command-line values. The summary then has one row per lane.
+//                  Lane state is allocated per touched 4096-voxel chunk,
+//                  4096 * lanes * (count + bank bytes) each, not per grid voxel.
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "VoxelGrid.hh"
+#include "VacancyModel.hh"
+#include "DepositTrace.hh"
+#include "VacancyBatch.hh"
+#include "VacancyKMC.hh"
+#include "SublatticeKMC.hh"
+#include "PotentialSolver.hh"
+#include "LeakageCurrent.hh"
+#include "Checkpoint.hh"
+
+using hfo2units::nm;
+
+static bool ApplyOption(const std::string& key, const std::string& val,
+                        VacancyModel::Params& p, std::string& summary, std::string& map,
+                        std::string& npy) {
+    if      (key == "W_eV")             p.W_eV = std::stod(val);
+    else if (key == "Ea_base_eV")       p.Ea_base_eV = std::stod(val);
+    else if (key == "Ea_fast_eV")       p.Ea_fast_eV = std::stod(val);
+    else if (key == "fastOnlyNearSeed") p.fastOnlyNearSeed = (std::stoi(val) != 0);
+    else if (key == "bankRelaxEvents")  p.bankRelaxEvents = std::stod(val);
+    else if (key == "vacConcCm3")       p.initConc_cm3 = std::stod(val);
+    else if (key == "vacSeed")          p.initSeed = std::stoull(val);
+    else if (key == "hfo2Rho_g_cm3")    p.rho_g_cm3 = std::stod(val);
+    else if (key == "trackPercolation") p.trackPercolation = (std::stoi(val) != 0);
+    else if (key == "stopOnPercolation") p.stopOnPercolation = (std::stoi(val) != 0);
+    else if (key == "summary")          summary = val;
+    else if (key == "map")              map = val;
+    else if (key == "npy")              npy = val;
+    else return false;
+    return true;
+}
+
+static bool ApplyKmcOption(const std::string& key, const std::string& val, VacancyKMC::Params& k) {
+    if      (key == "kmcTemperatureK")  k.T_K = std::stod(val);
+    else if (key == "kmcAttemptHz")     k.attempt_Hz = std::stod(val);
+    else if (key == "kmcEd_eV")         k.Ed_eV = std::stod(val);
+    else if (key == "kmcEg_eV")         k.Eg_eV = std::stod(val);
+    else if (key == "kmcEr_eV")         k.Er_eV = std::stod(val);
+    else if (key == "kmcGenDipole_eA")  k.genDipole_eA = std::stod(val);
+    else if (key == "kmcSeed")          k.seed = std::stoull(val);
+    else if (key == "kmcDtPerEvent_s")  k.dtPerEvent_s = std::stod(val);
+    else if (key == "kmcPostTime_s")    k.postTime_s = std::stod(val);
+    else if (key == "kmcThreads")       k.threads = std::stoi(val);
+    else if (key == "kmcSectorX")       k.sectorX = std::stoi(val);
+    else if (key == "kmcSectorY")       k.sectorY = std::stoi(val);
+    else if (key == "kmcWindow_s")      k.window_s = std::stod(val);
+    else if (key == "kmcMaxDense_MiB")  k.maxDense_MiB = std::stod(val);
+    else return false;
+    return true;
+}
+
+static bool ApplyFieldOption(const std::string& key, const std::string& val,
+                             PotentialSolver::Params& f, std::string& potential) {
+    if      (key == "field")       f.enabled = std::stoi(val) != 0;
+    else if (key == "fieldEvery")  { f.refreshEvery = std::stoi(val); f.enabled = true; }
+    else if (key == "Vtop")        f.Vtop_V = std::stod(val);
+    else if (key == "Vbottom")     f.Vbottom_V = std::stod(val);
+    else if (key == "epsOxide")    f.epsOxide = std::stod(val);
+    else if (key == "epsDefect")   f.epsDefect = std::stod(val);
+    else if (key == "potential")   { potential = val; f.enabled = true; }
+    else return false;
+    return true;
+}
+
+static bool ApplyTatOption(const std::string& key, const std::string& val, LeakageCurrent::Params& t) {
+    if      (key == "tat")              t.enabled = (std::stoi(val) != 0);
+    else if (key == "tatCutoffNm")      t.cutoffNm = std::stod(val);
+    else if (key == "tatTrapDepth_eV")  t.trapDepth_eV = std::stod(val);
+    else if (key == "tatBarrier_eV")    t.barrier_eV = std::stod(val);
+    else if (key == "tatMEff")          t.mEff = std::stod(val);
+    else return false;
+    return true;
+}
+
+static std::vector<std::string> SplitCsvLine(const std::string& line) {
+    std::vector<std::string> cols;
+    std::stringstream ss(line);
+    std::string col;
+    while (std::getline(ss, col, ',')) cols.push_back(col);
+    return cols;
+}
+
+static std::vector<VacancyModel::Params> ReadLanes(const std::string& path, const VacancyModel::Params& base) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Cannot open lanes file " + path);
+
+    std::string line;
+    std::getline(in, line);
+    const auto keys = SplitCsvLine(line);
+
+    std::vector<VacancyModel::Params> lanes;
+    std::string unusedSummary, unusedMap, unusedNpy;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        const auto vals = SplitCsvLine(line);
+        auto p = base;
+        for (size_t c = 0; c < keys.size() && c < vals.size(); ++c) {
+            if (!ApplyOption(keys[c], vals[c], p, unusedSummary, unusedMap, unusedNpy)) {
+                throw std::runtime_error("Unknown lane column: " + keys[c]);
+            }
+        }
+        lanes.push_back(p);
+    }
+    return lanes;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <trace.bin> [key=value ...]\n";
+        return 1;
+    }
+
+    VacancyModel vac;
+    VacancyKMC kmc;
+    PotentialSolver field;
+    LeakageCurrent tat;
+    std::string potentialPath;
+    std::string summaryPath = "replay_summary.csv";
+    std::string mapPath;
+    std::string npyPrefix;
+    std::string lanesPath;
+    std::string checkpointPath, restartPath;
+    long long checkpointEvery = 0, maxEvents = -1;
+
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto eq = arg.find('=');
+        if (eq != std::string::npos && arg.substr(0, eq) == "lanes") {
+            lanesPath = arg.substr(eq + 1);
+            continue;
+        }
+        if (eq != std::string::npos) {
+            const std::string key = arg.substr(0, eq), val = arg.substr(eq + 1);
+            if      (key == "checkpoint")      { checkpointPath = val; continue; }
+            else if (key == "checkpointEvery") { checkpointEvery = std::stoll(val); continue; }
+            else if (key == "restart")         { restartPath = val; continue; }
+            else if (key == "maxEvents")       { maxEvents = std::stoll(val); continue; }
+        }
+        if (eq == std::string::npos ||
+            (!ApplyOption(arg.substr(0, eq), arg.substr(eq + 1), vac.GetParams(), summaryPath, mapPath, npyPrefix) &&
+             !ApplyKmcOption(arg.substr(0, eq), arg.substr(eq + 1), kmc.GetParams()) &&
+             !ApplyFieldOption(arg.substr(0, eq), arg.substr(eq + 1), field.GetParams(), potentialPath) &&
+             !ApplyTatOption(arg.substr(0, eq), arg.substr(eq + 1), tat.GetParams()))) {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    DepositTraceReader reader;
+    if (!reader.Open(argv[1])) {
+        std::cerr << "Cannot open trace " << argv[1] << "\n";
+        return 1;
+    }
+
+    // Rebuild the scoring grid from the trace header (same counts, Flatten and
+    // seed as the run)
+    const auto& h = reader.Header();
+    const Vec3 minCorner(h.min_nm[0]*nm, h.min_nm[1]*nm, h.min_nm[2]*nm);
+    VoxelGrid grid;
+    grid.Configure(minCorner, h.nx, h.ny, h.nz, h.dx_nm*nm, h.dy_nm*nm, h.dz_nm*nm);
+
+    EventRecord rec;
+    long long nEvents = 0;
+
+    if (!lanesPath.empty()) {
+        VacancyBatch batch(ReadLanes(lanesPath, vac.GetParams()));
+        batch.ConfigureFromGrid(grid);
+
+        const auto t0 = std::chrono::steady_clock::now();
+        while (reader.Next(rec)) {
+            batch.ProcessEvent(rec);
+            ++nEvents;
+        }
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "Replayed " << nEvents << " events x " << batch.Lanes()
+                  << " parameter lanes in " << sec << " s ("
+                  << batch.AllocatedChunks() << " chunks, "
+                  << batch.MemoryBytes() / (1024.0 * 1024.0) << " MiB lane state)\n";
+
+        batch.ExportSummaryCSV(summaryPath, nEvents);
+        return 0;
+    }
+
+    vac.ConfigureFromGrid(grid);   // also draws the initial vacancy field
+    long long eventBase = 0;
+    if (!restartPath.empty()) {
+        eventBase = Checkpoint::Read(restartPath, grid, vac).eventsDone;
+        std::cout << "Restarted from " << restartPath << " after " << eventBase << " events\n";
+    }
+    if (kmc.GetParams().dtPerEvent_s > 0.0) kmc.Attach(vac);
+    if (field.GetParams().enabled) {
+        field.Configure(grid);
+        if (field.GetParams().refreshEvery > 0) field.Solve(vac);
+        kmc.SetField(&field);
+    }
+    const int fieldEvery = field.GetParams().refreshEvery;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    while ((maxEvents < 0 || nEvents < maxEvents) && reader.Next(rec)) {
+        if (rec.eventId < eventBase) continue;
+        grid.AddEventToRun(rec);
+        vac.ProcessEvent(rec);
+        if (kmc.IsAttached()) {
+            kmc.OnEvent(rec);
+            kmc.Advance(kmc.GetParams().dtPerEvent_s);
+            vac.UpdatePercolation(rec.eventId);
+        }
+        ++nEvents;
+        if (fieldEvery > 0 && nEvents % fieldEvery == 0) {
+            if (field.FinishRefresh() && kmc.IsAttached()) kmc.FieldChanged();
+            field.BeginRefresh(vac);
+        }
+        if (checkpointEvery > 0 && nEvents % checkpointEvery == 0 && !checkpointPath.empty()) {
+            Checkpoint::Write(checkpointPath, grid, vac, {eventBase + nEvents, 0});
+        }
+        if (vac.StopRequested()) break;
+    }
+    if (!checkpointPath.empty() && !Checkpoint::Write(checkpointPath, grid, vac, {eventBase + nEvents, 0})) {
+        std::cerr << "Cannot write checkpoint " << checkpointPath << "\n";
+    }
+    const auto& kp = kmc.GetParams();
+    std::unique_ptr<SublatticeKMC> parKmc;
+    if (kp.postTime_s > 0.0 && kp.threads > 0) {
+        parKmc.reset(new SublatticeKMC(kp));
+        parKmc->Attach(vac);
+        const auto tk = std::chrono::steady_clock::now();
+        parKmc->Advance(kp.postTime_s);
+        const double ksec = std::chrono::duration<double>(std::chrono::steady_clock::now() - tk).count();
+        std::cout << "KMC (" << parKmc->Threads() << " threads, " << parKmc->Sectors() << " sectors): t = "
+                  << parKmc->Time() << " s, " << parKmc->Steps() << " steps in " << ksec
+                  << " s, parallel efficiency " << parKmc->ParallelEfficiency()
+                  << ", boundary conflicts " << parKmc->Conflicts() << "/" << parKmc->BoundaryEvents() << "\n";
+    } else if (kmc.Enabled()) {
+        if (!kmc.IsAttached()) kmc.Attach(vac);
+        if (kp.postTime_s > 0.0) kmc.Advance(kp.postTime_s);
+    }
+    if (kmc.IsAttached()) {
+        std::cout << "KMC: t = " << kmc.Time() << " s, " << kmc.Steps() << " steps ("
+                  << kmc.Generated() << " generated, " << kmc.Recombined() << " recombined, "
+                  << kmc.Hops() << " hops)\n";
+    }
+
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Replayed " << nEvents << " events in " << sec << " s, "
+              << vac.TotalCreated() << " vacancies created\n";
+    if (vac.GetParams().trackPercolation) {
+        if (vac.Percolated()) std::cout << "Percolation: spanning cluster at event " << vac.PercolationEvent() << "\n";
+        else std::cout << "Percolation: no spanning cluster\n";
+    }
+
+    if (field.IsConfigured()) {
+        const auto tf = std::chrono::steady_clock::now();
+        const int cycles = field.Solve(vac);
+        const double fsec = std::chrono::duration<double>(std::chrono::steady_clock::now() - tf).count();
+        std::cout << "Potential: " << cycles << " V-cycles in " << fsec << " s, relative residual "
+                  << field.Residual() << " (" << field.Solves() << " solves)\n";
+        if (!potentialPath.empty()) field.ExportNpy(potentialPath);
+    }
+
+    if (tat.GetParams().enabled) {
+        const auto tt = std::chrono::steady_clock::now();
+        const auto& fp = field.GetParams();
+        tat.Build(grid, vac, field.IsConfigured() ? &field : nullptr, fp.Vbottom_V, fp.Vtop_V);
+        const int sweeps = tat.Solve();
+        const double tsec = std::chrono::duration<double>(std::chrono::steady_clock::now() - tt).count();
+        std::cout << "TAT current: " << tat.CurrentTop_A() << " A (" << tat.Sites() << " trap sites, "
+                  << tat.Pairs() << " pairs, " << sweeps << " sweeps in " << tsec
+                  << " s, last change " << tat.Change() << ")\n";
+    }
+
+    vac.ExportSummaryCSV(summaryPath, eventBase + nEvents);
+    if (kmc.IsAttached() || parKmc || tat.GetParams().enabled) {
+        std::ofstream summary(summaryPath, std::ios::app);
+        if (kmc.IsAttached()) kmc.WriteSummaryRows(summary);
+        if (parKmc) parKmc->WriteSummaryRows(summary);
+        if (tat.GetParams().enabled) tat.WriteSummaryRows(summary);
+    }
+    if (!mapPath.empty()) vac.ExportVacancyCSV(mapPath, grid);
+    if (!npyPrefix.empty()) {
+        vac.ExportVacancyNpy(npyPrefix);
+        grid.ExportEdepNpy(npyPrefix + "_edep.npy");
+    }
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include "PrimaryGeneratorAction.hh"
 #include "RunAction.hh"
 #include "SteppingAction.hh"
+#include "StackingAction.hh"
 
 #include "G4RunManager.hh"
 
@@ -11,9 +12,17 @@
 
 ActionInitialization::ActionInitialization(DetectorConstruction* det) : fDet(det) {}
 
+void ActionInitialization::BuildForMaster() const {
+    // Master only owns run bookkeeping and the end-of-run exports
+    SetUserAction(new RunAction(fDet));
+}
+
 void ActionInitialization::Build() const {
-    SetUserAction(new PrimaryGeneratorAction());
+    SetUserAction(new PrimaryGeneratorAction(fDet));
     SetUserAction(new RunAction(fDet));
-    SetUserAction(new EventAction(fDet));
-    SetUserAction(new SteppingAction(fDet));
+
+    auto eventAction = new EventAction(fDet);
+    SetUserAction(eventAction);
+    SetUserAction(new SteppingAction(fDet, eventAction));
+    SetUserAction(new StackingAction(fDet));
 }
\ No newline at end of file
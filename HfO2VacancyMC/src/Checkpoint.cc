@@ -0,0 +1,137 @@
+#include "Checkpoint.hh"
+#include "VoxelGrid.hh"
+#include "VacancyModel.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using hfo2units::nm;
+
+static constexpr char kCheckpointMagic[8] = {'H','F','O','2','C','K','P','1'};
+static constexpr uint32_t kCheckpointVersion = 5;   // 2: storage layout id, 3: storage types id, 4: bank clock,
+                                                    // 5: counter-based initial vacancy field
+
+template <class T>
+static void WritePod(std::ostream& out, const T& v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <class T>
+static bool ReadPod(std::istream& in, T& v) {
+    return (bool)in.read(reinterpret_cast<char*>(&v), sizeof(T));
+}
+
+static void WriteState(std::ostream& out, const VoxelGrid& grid, const VacancyModel& vac,
+                       const Checkpoint::Info& info) {
+    out.write(kCheckpointMagic, sizeof(kCheckpointMagic));
+    WritePod(out, kCheckpointVersion);
+    WritePod(out, VoxelLayout::kId);
+    WritePod(out, VoxelStorage::kId);
+    WritePod(out, (int32_t)grid.Nx());
+    WritePod(out, (int32_t)grid.Ny());
+    WritePod(out, (int32_t)grid.Nz());
+    WritePod(out, grid.Dx() / nm);
+    WritePod(out, grid.Dy() / nm);
+    WritePod(out, grid.Dz() / nm);
+    WritePod(out, grid.Min().x() / nm);
+    WritePod(out, grid.Min().y() / nm);
+    WritePod(out, grid.Min().z() / nm);
+    WritePod(out, (int64_t)info.eventsDone);
+    WritePod(out, info.eventSeed);
+
+    grid.SaveRunState(out);
+    vac.SaveState(out);
+}
+
+bool Checkpoint::Write(const std::string& path, const VoxelGrid& grid, const VacancyModel& vac,
+                       const Info& info) {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        WriteState(out, grid, vac, info);
+        if (!out.flush()) return false;
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+std::string Checkpoint::Snapshot(const VoxelGrid& grid, const VacancyModel& vac, const Info& info) {
+    std::ostringstream out(std::ios::binary);
+    WriteState(out, grid, vac, info);
+    return out.str();
+}
+
+bool Checkpoint::WriteBytes(const std::string& path, const std::string& bytes) {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(bytes.data(), (std::streamsize)bytes.size());
+        if (!out.flush()) return false;
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+Checkpoint::Info Checkpoint::Read(const std::string& path, VoxelGrid& grid, VacancyModel& vac) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Checkpoint: cannot open " + path);
+
+    char magic[8];
+    uint32_t version = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kCheckpointMagic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Checkpoint: not a checkpoint: " + path);
+    }
+    if (!ReadPod(in, version) || version < 1 || version > kCheckpointVersion) {
+        throw std::runtime_error("Checkpoint: unsupported version in " + path);
+    }
+    uint32_t layout = RowMajorLayout::kId;   // version 1
+    if (version >= 2 && !ReadPod(in, layout)) {
+        throw std::runtime_error("Checkpoint: truncated header in " + path);
+    }
+    if (layout != VoxelLayout::kId) {
+        throw std::runtime_error("Checkpoint: " + path + " was written with another voxel layout "
+                                 "(this build uses " + VoxelLayout::kName + ")");
+    }
+    uint32_t storage = WideStorage::kId;   // versions 1, 2
+    if (version >= 3 && !ReadPod(in, storage)) {
+        throw std::runtime_error("Checkpoint: truncated header in " + path);
+    }
+    if (storage != VoxelStorage::kId) {
+        throw std::runtime_error("Checkpoint: " + path + " was written with other voxel storage types "
+                                 "(this build uses " + VoxelStorage::kName + ")");
+    }
+
+    // Untouched chunks are redrawn on restart, from another generator before version 5
+    if (version < 5 && vac.GetParams().initConc_cm3 > 0.0) {
+        throw std::runtime_error("Checkpoint: " + path + " predates the current initial vacancy "
+                                 "field generator (restart it with vacConcCm3 = 0 only)");
+    }
+
+    int32_t n[3];
+    double d_nm[3], min_nm[3];
+    bool ok = true;
+    for (auto& v : n) ok = ok && ReadPod(in, v);
+    for (auto& v : d_nm) ok = ok && ReadPod(in, v);
+    for (auto& v : min_nm) ok = ok && ReadPod(in, v);
+    int64_t done = 0;
+    Info info;
+    ok = ok && ReadPod(in, done) && ReadPod(in, info.eventSeed);
+    if (!ok) throw std::runtime_error("Checkpoint: truncated header in " + path);
+    info.eventsDone = done;
+
+    const double tol = 1e-9;
+    if (n[0] != grid.Nx() || n[1] != grid.Ny() || n[2] != grid.Nz() ||
+        std::abs(d_nm[0] - grid.Dx() / nm) > tol || std::abs(d_nm[1] - grid.Dy() / nm) > tol ||
+        std::abs(d_nm[2] - grid.Dz() / nm) > tol || std::abs(min_nm[0] - grid.Min().x() / nm) > tol ||
+        std::abs(min_nm[1] - grid.Min().y() / nm) > tol || std::abs(min_nm[2] - grid.Min().z() / nm) > tol) {
+        throw std::runtime_error("Checkpoint: voxel grid differs from the current geometry in " + path);
+    }
+
+    grid.LoadRunState(in);
+    vac.LoadState(in, version >= 4);
+    return info;
+}
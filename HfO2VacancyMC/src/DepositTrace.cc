@@ -0,0 +1,105 @@
+#include "DepositTrace.hh"
+#include "VoxelLayout.hh"
+
+#include <cstring>
+#include <stdexcept>
+
+static constexpr char kTraceMagic[8] = {'H','F','O','2','T','R','C','1'};
+static constexpr uint32_t kTraceVersion = 2;   // 2: storage layout id
+static constexpr size_t kTraceBufferBytes = 8u << 20; // 8 MiB stream buffer
+
+template <class T>
+static void WritePod(std::ostream& out, const T& v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <class T>
+static bool ReadPod(std::istream& in, T& v) {
+    return (bool)in.read(reinterpret_cast<char*>(&v), sizeof(T));
+}
+
+bool DepositTraceWriter::Open(const std::string& path, const DepositTraceHeader& h) {
+    Close();
+    fBuffer.resize(kTraceBufferBytes);
+    fOut.rdbuf()->pubsetbuf(fBuffer.data(), (std::streamsize)fBuffer.size());
+    fOut.open(path, std::ios::binary | std::ios::trunc);
+    if (!fOut) return false;
+
+    fOut.write(kTraceMagic, sizeof(kTraceMagic));
+    WritePod(fOut, kTraceVersion);
+    WritePod(fOut, VoxelLayout::kId);
+    WritePod(fOut, h.nx);
+    WritePod(fOut, h.ny);
+    WritePod(fOut, h.nz);
+    WritePod(fOut, h.dx_nm);
+    WritePod(fOut, h.dy_nm);
+    WritePod(fOut, h.dz_nm);
+    for (double m : h.min_nm) WritePod(fOut, m);
+
+    fEvents = 0;
+    return (bool)fOut;
+}
+
+void DepositTraceWriter::Write(const EventRecord& rec) {
+    if (!fOut.is_open()) return;
+
+    const int64_t id = rec.eventId;
+    const uint32_t n = (uint32_t)rec.Size();
+    WritePod(fOut, id);
+    WritePod(fOut, n);
+
+    static_assert(sizeof(size_t) == sizeof(uint64_t), "trace stores 64-bit voxel indices");
+    fOut.write(reinterpret_cast<const char*>(rec.flat.data()), (std::streamsize)(n * sizeof(uint64_t)));
+    fOut.write(reinterpret_cast<const char*>(rec.edep_eV.data()), (std::streamsize)(n * sizeof(double)));
+    ++fEvents;
+}
+
+void DepositTraceWriter::Close() {
+    if (fOut.is_open()) fOut.close();
+}
+
+bool DepositTraceReader::Open(const std::string& path) {
+    fBuffer.resize(kTraceBufferBytes);
+    fIn.rdbuf()->pubsetbuf(fBuffer.data(), (std::streamsize)fBuffer.size());
+    fIn.open(path, std::ios::binary);
+    if (!fIn) return false;
+
+    char magic[8];
+    uint32_t version = 0;
+    if (!fIn.read(magic, sizeof(magic)) || std::memcmp(magic, kTraceMagic, sizeof(magic)) != 0) {
+        throw std::runtime_error("DepositTrace: not a deposition trace: " + path);
+    }
+    if (!ReadPod(fIn, version) || version < 1 || version > kTraceVersion) {
+        throw std::runtime_error("DepositTrace: unsupported trace version in " + path);
+    }
+    // Flat indices are only meaningful in the layout they were written in
+    uint32_t layout = RowMajorLayout::kId;   // version 1
+    if (version >= 2 && !ReadPod(fIn, layout)) {
+        throw std::runtime_error("DepositTrace: truncated header in " + path);
+    }
+    if (layout != VoxelLayout::kId) {
+        throw std::runtime_error("DepositTrace: " + path + " was written with another voxel layout "
+                                 "(this build uses " + VoxelLayout::kName + ")");
+    }
+
+    auto& h = fHeader;
+    bool ok = ReadPod(fIn, h.nx) && ReadPod(fIn, h.ny) && ReadPod(fIn, h.nz) &&
+              ReadPod(fIn, h.dx_nm) && ReadPod(fIn, h.dy_nm) && ReadPod(fIn, h.dz_nm);
+    for (double& m : h.min_nm) ok = ok && ReadPod(fIn, m);
+    if (!ok) throw std::runtime_error("DepositTrace: truncated header in " + path);
+    return true;
+}
+
+bool DepositTraceReader::Next(EventRecord& rec) {
+    int64_t id = 0;
+    uint32_t n = 0;
+    if (!ReadPod(fIn, id) || !ReadPod(fIn, n)) return false;
+
+    rec.eventId = id;
+    rec.flat.resize(n);
+    rec.edep_eV.resize(n);
+    fIn.read(reinterpret_cast<char*>(rec.flat.data()), (std::streamsize)(n * sizeof(uint64_t)));
+    fIn.read(reinterpret_cast<char*>(rec.edep_eV.data()), (std::streamsize)(n * sizeof(double)));
+    if (!fIn) throw std::runtime_error("DepositTrace: truncated event record");
+    return true;
+}
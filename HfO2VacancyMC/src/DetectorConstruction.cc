@@ -12,6 +12,7 @@
 
 #include "G4Region.hh"
 #include "G4ProductionCuts.hh"
+#include "G4UserLimits.hh"
 
 DetectorConstruction::DetectorConstruction() {
     fMessenger = new G4GenericMessenger(this, "/det/", "Detector control");
@@ -23,10 +24,83 @@ DetectorConstruction::DetectorConstruction() {
     fMessenger->DeclareProperty("voxelDxNm", fVoxelDxNm, "Voxel size X in nm (HfO2 scoring grid)");
     fMessenger->DeclareProperty("voxelDyNm", fVoxelDyNm, "Voxel size Y in nm (HfO2 scoring grid)");
     fMessenger->DeclareProperty("voxelDzNm", fVoxelDzNm, "Voxel size Z in nm (HfO2 scoring grid)");
+    fMessenger->DeclareProperty("splitSteps", fSplitSteps,
+        "Split each HfO2 step deposit over the voxels it crosses (3D-DDA) instead of binning at the step midpoint");
+    fMessenger->DeclareProperty("hfo2MaxStepNm", fHfO2MaxStepNm,
+        "Step limit in HfO2 in nm, 0 = none (set before /run/initialize)");
 
+    fMessenger->DeclareProperty("bankRelaxEvents", fVacancy.GetParams().bankRelaxEvents,
+        "E-folding time of the voxel energy banks in events (relaxation time x primaries/s); 0 = no decay");
     fMessenger->DeclareProperty("vacConcCm3", fVacancy.GetParams().initConc_cm3, "Initial oxygen vacancy concentration in cm^-3");
     fMessenger->DeclareProperty("vacSeed", fVacancy.GetParams().initSeed, "Seed for vacancy initialization");
     fMessenger->DeclareProperty("hfo2Rho_g_cm3", fVacancy.GetParams().rho_g_cm3, "HfO2 density in g/cm3 (affects max vacancy capacity)");
+    fMessenger->DeclareProperty("trackPercolation", fVacancy.GetParams().trackPercolation,
+        "Track vacancy clusters and report the event at which one spans top to bottom");
+    fMessenger->DeclareProperty("stopOnPercolation", fVacancy.GetParams().stopOnPercolation,
+        "End the run at the first spanning cluster (needs trackPercolation)");
+
+    auto& kmc = fKMC.GetParams();
+    fKmcMessenger = new G4GenericMessenger(this, "/kmc/", "Vacancy kinetic Monte Carlo");
+    fKmcMessenger->DeclareProperty("temperatureK", kmc.T_K, "Lattice temperature in K");
+    fKmcMessenger->DeclareProperty("attemptHz", kmc.attempt_Hz, "Attempt frequency in Hz");
+    fKmcMessenger->DeclareProperty("Ed_eV", kmc.Ed_eV, "Migration barrier in eV");
+    fKmcMessenger->DeclareProperty("Eg_eV", kmc.Eg_eV, "Generation barrier in eV");
+    fKmcMessenger->DeclareProperty("Er_eV", kmc.Er_eV, "Recombination barrier in eV");
+    fKmcMessenger->DeclareProperty("genDipole_eA", kmc.genDipole_eA,
+        "Field-assisted generation: Eg lowered by this dipole (e*Angstrom) times |E| from /field/; 0 = off");
+    fKmcMessenger->DeclareProperty("seed", kmc.seed, "KMC random seed");
+    fKmcMessenger->DeclareProperty("dtPerEvent_s", kmc.dtPerEvent_s,
+        "KMC time (s) simulated after each committed event; 0 = no interleaving");
+    fKmcMessenger->DeclareProperty("postTime_s", kmc.postTime_s,
+        "KMC time (s) simulated after the last event; 0 = none");
+    fKmcMessenger->DeclareProperty("threads", kmc.threads,
+        "Threads for the post-irradiation KMC (parallel sublattice); 0 = serial");
+    fKmcMessenger->DeclareProperty("sectorX", kmc.sectorX, "Sublattice sector size along x (voxels)");
+    fKmcMessenger->DeclareProperty("sectorY", kmc.sectorY, "Sublattice sector size along y (voxels)");
+    fKmcMessenger->DeclareProperty("window_s", kmc.window_s, "Sublattice time window per sector colour (s)");
+    fKmcMessenger->DeclareProperty("maxDense_MiB", kmc.maxDense_MiB,
+        "Largest dense vacancy-count slab the KMC may allocate (MiB); larger grids are refused");
+
+    auto& field = fPotential.GetParams();
+    fFieldMessenger = new G4GenericMessenger(this, "/field/", "Electrostatic potential in HfO2");
+    fFieldMessenger->DeclareProperty("enable", field.enabled, "Solve the potential (end of run and every refreshEvery events)");
+    fFieldMessenger->DeclareProperty("Vtop", field.Vtop_V, "Top electrode potential (z = 0) in V");
+    fFieldMessenger->DeclareProperty("Vbottom", field.Vbottom_V, "Bottom electrode potential (Si interface) in V");
+    fFieldMessenger->DeclareProperty("refreshEvery", field.refreshEvery,
+        "Committed events between in-run solves (on a worker thread, seen one interval later); 0 = end of run only");
+    fFieldMessenger->DeclareProperty("epsOxide", field.epsOxide, "Relative permittivity of vacancy-free HfO2");
+    fFieldMessenger->DeclareProperty("epsDefect", field.epsDefect, "Relative permittivity of a voxel full of vacancies");
+    fFieldMessenger->DeclareProperty("tolerance", field.tolerance, "Relative residual for the multigrid solve");
+
+    auto& tat = fLeakage.GetParams();
+    fTatMessenger = new G4GenericMessenger(this, "/tat/", "Trap-assisted tunnelling current");
+    fTatMessenger->DeclareProperty("enable", tat.enabled, "Compute the TAT current at the end of the run");
+    fTatMessenger->DeclareProperty("cutoffNm", tat.cutoffNm, "Tunnelling cutoff distance (nm)");
+    fTatMessenger->DeclareProperty("trapDepth_eV", tat.trapDepth_eV, "Trap level below the HfO2 conduction band (eV)");
+    fTatMessenger->DeclareProperty("barrier_eV", tat.barrier_eV, "Electrode work function minus HfO2 electron affinity (eV)");
+    fTatMessenger->DeclareProperty("mEff", tat.mEff, "Tunnelling effective mass (units of m_e)");
+    fTatMessenger->DeclareProperty("nuTrap_Hz", tat.nuTrap_Hz, "Trap-to-trap attempt frequency (Hz)");
+    fTatMessenger->DeclareProperty("nuElectrode_Hz", tat.nuElectrode_Hz, "Electrode-to-trap attempt frequency (Hz)");
+    fTatMessenger->DeclareProperty("temperatureK", tat.T_K, "Temperature (K)");
+    fTatMessenger->DeclareProperty("tolerance", tat.tolerance, "Relative occupancy change per sweep at convergence");
+    fTatMessenger->DeclareProperty("omega", tat.omega, "Over-relaxation factor of the occupancy sweeps (1..2)");
+
+    auto& perf = fPerf.GetParams();
+    fPerfMessenger = new G4GenericMessenger(&fPerf, "/perf/", "Run instrumentation");
+    fPerfMessenger->DeclareProperty("enable", perf.enabled,
+        "Count steps per volume, touched voxels and vacancies per event, and time each phase; perf.csv at end of run");
+    fPerfMessenger->DeclareProperty("interval", perf.interval, "Committed events between throughput lines; 0 = none");
+    fPerfMessenger->DeclareMethod("dump", &PerfMonitor::Dump, "Print the current counters and write perf.csv");
+
+    auto& sub = fSubstrate.GetParams();
+    fSubstrateMessenger = new G4GenericMessenger(this, "/substrate/", "Electron killing and roulette in the Si substrate");
+    fSubstrateMessenger->DeclareProperty("enable", sub.enabled,
+        "Kill electrons in SiPV whose CSDA range cannot reach the HfO2 interface");
+    fSubstrateMessenger->DeclareProperty("rangeSafety", sub.rangeSafety, "CSDA range multiplier before comparing with the depth");
+    fSubstrateMessenger->DeclareProperty("maxEnergy_keV", sub.maxEnergy_keV, "Top of the range table; faster electrons are kept");
+    fSubstrateMessenger->DeclareProperty("roulette", sub.roulette, "Russian roulette for low-energy secondaries born in SiPV");
+    fSubstrateMessenger->DeclareProperty("rouletteEnergy_keV", sub.rouletteEnergy_keV, "Secondaries below this energy play roulette");
+    fSubstrateMessenger->DeclareProperty("rouletteSurvival", sub.rouletteSurvival, "Survival probability; survivors get weight 1/p");
 }
 
 void DetectorConstruction::DefineMaterials() {
@@ -76,14 +150,14 @@ G4VPhysicalVolume* DetectorConstruction::Construct() {
     auto HfMat = G4Material::GetMaterial("HfO2");
     fLogicHfO2 = new G4LogicalVolume(solidHf, HfMat, "HfO2LV");
     const G4ThreeVector posHf(0, 0, -tHf/2);
-    new G4PVPlacement(nullptr, posHf, fLogicHfO2, "HfO2PV", fLogicWorld, false, 0);
+    fPhysHfO2 = new G4PVPlacement(nullptr, posHf, fLogicHfO2, "HfO2PV", fLogicWorld, false, 0);
 
     // Si volume
     auto solidSi = new G4Box("Si", padXY/2, padXY/2, tSi/2);
     auto siMat = nist->FindOrBuildMaterial("G4_Si");
     fLogicSi = new G4LogicalVolume(solidSi, siMat, "SiLV");
     const G4ThreeVector posSi(0, 0, -(tHf + tSi/2));
-    new G4PVPlacement(nullptr, posSi, fLogicSi, "SiPV", fLogicWorld, false, 0);
+    fPhysSi = new G4PVPlacement(nullptr, posSi, fLogicSi, "SiPV", fLogicWorld, false, 0);
 
     // Setup scoring voxel grid bounds exactly matching HfO2 volume in world coords:
     // HfO2 box spans x,y in [-padXY/2, +padXY/2] and z in [-tHf, 0]
@@ -114,6 +188,17 @@ void DetectorConstruction::SetupRegionsAndCuts() {
     cuts->SetProductionCut(5*nm,    "e+");
 
     fHfO2Region->SetProductionCuts(cuts);
+
+    // Optional step limit (G4StepLimiterPhysics in PhysicsList). Binning at the
+    // midpoint needs steps short against the voxel pitch; with /det/splitSteps
+    // it can be relaxed or dropped.
+    if (fHfO2MaxStepNm > 0.0) fLogicHfO2->SetUserLimits(new G4UserLimits(fHfO2MaxStepNm*nm));
+
+    // Substrate region: default cuts (/run/setCutForRegion SiRegion ...) and
+    // the standard EM models, it only returns backscattered electrons
+    fSiRegion = new G4Region("SiRegion");
+    fLogicSi->SetRegion(fSiRegion);
+    fSiRegion->AddRootLogicalVolume(fLogicSi);
 }
 
 void DetectorConstruction::ConstructSDandField() {
@@ -0,0 +1,147 @@
+#include "EnsembleRunner.hh"
+#include "EnsembleStats.hh"
+
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "G4ios.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+// Two seeds per realization from one base: splitmix64 of (base, 2i) and (base, 2i+1)
+uint64_t RealizationSeed(uint64_t base, uint64_t k) {
+    uint64_t z = base + 0x9E3779B97F4A7C15ull * (k + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return ((z ^ (z >> 31)) >> 1) | 1;   // positive and non-zero
+}
+
+std::string RealizationDir(const std::string& dir, int i) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/r%04d", i);
+    return dir + name;
+}
+}
+
+EnsembleRunner::EnsembleRunner(G4RunManager* runManager) : fRunManager(runManager) {
+    fMessenger = new G4GenericMessenger(this, "/ensemble/", "Forked ensemble of independent realizations");
+    fMessenger->DeclareProperty("realizations", fRealizations, "Number of realizations");
+    fMessenger->DeclareProperty("events", fEvents, "Primaries per realization");
+    fMessenger->DeclareProperty("jobs", fJobs, "Concurrent realizations (processes); 0 = hardware threads");
+    fMessenger->DeclareProperty("baseSeed", fBaseSeed, "Base of the per-realization seed pairs");
+    fMessenger->DeclareProperty("dir", fDir, "Output directory (one r<i> subdirectory per realization)");
+    fMessenger->DeclareProperty("report", fReport, "Merged ensemble summary (CSV)");
+    fMessenger->DeclareMethod("run", &EnsembleRunner::Run, "Initialize once, fork the realizations and merge");
+}
+
+void EnsembleRunner::Run() {
+    if (fRunManager->GetRunManagerType() != G4RunManager::sequentialRM) {
+        G4cerr << "EnsembleRunner: needs the serial run manager (G4RUN_MANAGER_TYPE=Serial)" << G4endl;
+        return;
+    }
+
+    auto ui = G4UImanager::GetUIpointer();
+    // Geometry, physics tables and cross-section data are built here, once
+    fRunManager->BeamOn(0);
+
+    if (::mkdir(fDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        G4cerr << "EnsembleRunner: cannot create " << fDir << G4endl;
+        return;
+    }
+
+    const int jobs = fJobs > 0 ? fJobs : std::max(1u, std::thread::hardware_concurrency());
+    std::map<pid_t, int> running;
+    int next = 0, failed = 0;
+
+    while (next < fRealizations || !running.empty()) {
+        while (next < fRealizations && (int)running.size() < jobs) {
+            const int i = next++;
+            const std::string dir = RealizationDir(fDir, i);
+            ::mkdir(dir.c_str(), 0755);
+
+            G4cout.flush();
+            std::fflush(nullptr);
+            const pid_t pid = ::fork();
+            if (pid < 0) {
+                G4cerr << "EnsembleRunner: fork failed for realization " << i << G4endl;
+                ++failed;
+                continue;
+            }
+            if (pid == 0) {
+                // Child: private working directory and log, own seeds, one run
+                int rc = 1;
+                if (::chdir(dir.c_str()) == 0) {
+                    const int log = ::open("run.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                    if (log >= 0) {
+                        ::dup2(log, 1);
+                        ::dup2(log, 2);
+                        ::close(log);
+                    }
+                    ui->ApplyCommand("/det/vacSeed " + std::to_string(RealizationSeed(fBaseSeed, 2 * (uint64_t)i)));
+                    ui->ApplyCommand("/ckpt/eventSeed " + std::to_string(RealizationSeed(fBaseSeed, 2 * (uint64_t)i + 1)));
+                    fRunManager->BeamOn(fEvents);
+                    std::fflush(nullptr);
+                    rc = 0;
+                }
+                std::_Exit(rc);   // no destructors: the parent owns the kernel
+            }
+            running[pid] = i;
+        }
+
+        int status = 0;
+        const pid_t done = ::wait(&status);
+        if (done < 0) break;
+        auto it = running.find(done);
+        if (it == running.end()) continue;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            G4cerr << "EnsembleRunner: realization " << it->second << " failed" << G4endl;
+            ++failed;
+        }
+        running.erase(it);
+    }
+
+    // Merge the per-realization summaries
+    EnsembleStats stats;
+    int merged = 0;
+    for (int i = 0; i < fRealizations; ++i) {
+        if (stats.AddSummaryCSV(RealizationDir(fDir, i) + "/hfO2_vacancy_summary.csv") > 0) ++merged;
+    }
+
+    std::ofstream out(fReport);
+    stats.WriteCSV(out);
+
+    // Breakdown statistics: events to filament (percolationEvent + 1)
+    if (stats.Count("percolated") > 0) {
+        const auto& flag = stats.Values("percolated");
+        const auto& event = stats.Values("percolationEvent");
+        std::vector<double> times;
+        for (size_t k = 0; k < flag.size() && k < event.size(); ++k) {
+            if (flag[k] > 0.5) times.push_back(event[k] + 1.0);
+        }
+        double shape = 0, scale = 0;
+        out << "breakdown_fraction," << flag.size() << "," << (double)times.size() / (double)flag.size()
+            << ",,,,,,\n";
+        if (EnsembleStats::WeibullFit(times, flag.size(), shape, scale)) {
+            out << "weibull_shape," << times.size() << "," << shape << ",,,,,,\n";
+            out << "weibull_scale_events," << times.size() << "," << scale << ",,,,,,\n";
+        }
+    }
+
+    G4cout << "Ensemble: " << merged << "/" << fRealizations << " realizations merged into " << fReport;
+    if (failed > 0) G4cout << " (" << failed << " failed)";
+    G4cout << G4endl;
+}
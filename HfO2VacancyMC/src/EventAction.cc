@@ -3,13 +3,32 @@
 #include "VoxelGrid.hh"
 #include "VacancyModel.hh"
 
+#include "G4Event.hh"
+#include "G4RunManager.hh"
+
 EventAction::EventAction(DetectorConstruction* det) : fDet(det) {}
 
 void EventAction::BeginOfEventAction(const G4Event*) {
-    fDet->GetVoxelGrid().ResetEventAccumulators();
+    // Geometry may have been rebuilt between runs: follow the master grid
+    const auto& runGrid = fDet->GetVoxelGrid();
+    if (!fEventGrid.SameShape(runGrid)) {
+        fEventGrid.ConfigureEventAccumulators(runGrid);
+    }
+    fEventGrid.ResetEventAccumulators();
+    if (fDet->GetPerfMonitor().Enabled()) fPerfSample.Begin();
 }
 
-void EventAction::EndOfEventAction(const G4Event*) {
-    // Process this event's deposition into vacancy state
-    fDet->GetVacancyModel().ProcessEvent(fDet->GetVoxelGrid());
+void EventAction::EndOfEventAction(const G4Event* event) {
+    // Hand this event's deposition to the ordered commit stage, which feeds
+    // the run grid and the vacancy model
+    fEventGrid.FillEventRecord(fRecord);
+    fRecord.eventId = event->GetEventID();
+    auto& perf = fDet->GetPerfMonitor();
+    if (perf.Enabled()) perf.EndEvent(fPerfSample);   // before the commit: transport only
+    auto& committer = fDet->GetCommitter();
+    committer.Commit(std::move(fRecord));
+    fRecord.Clear();
+
+    // Filament formed and the run should end there: stop this thread's event loop
+    if (committer.Stopped()) G4RunManager::GetRunManager()->AbortRun(true);
 }
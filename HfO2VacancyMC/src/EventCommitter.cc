@@ -0,0 +1,134 @@
+#include "EventCommitter.hh"
+#include "VoxelGrid.hh"
+#include "VacancyModel.hh"
+#include "DepositTrace.hh"
+#include "VacancyKMC.hh"
+#include "PotentialSolver.hh"
+#include "Checkpoint.hh"
+#include "PerfMonitor.hh"
+
+#include "G4ios.hh"
+
+EventCommitter::EventCommitter(VoxelGrid& runGrid, VacancyModel& vacancy)
+    : fGrid(runGrid), fVacancy(vacancy) {}
+
+void EventCommitter::Reset() {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fPending.clear();
+    fNextId = 0;
+    fCommitted = 0;
+    fDropped = 0;
+    fSnapshot.clear();
+    std::lock_guard<std::mutex> wlock(fWriteMutex);
+    fWrittenEvents = -1;
+}
+
+void EventCommitter::Apply(EventRecord& rec) {
+    if (fVacancy.StopRequested()) {
+        ++fDropped;
+        return;
+    }
+    rec.eventId += fEventBase;
+    if (fTrace) fTrace->Write(rec);
+    fGrid.AddEventToRun(rec);
+    if (fPerf && fPerf->Enabled()) {
+        const auto t0 = PerfMonitor::Clock::now();
+        const long long created = fVacancy.TotalCreated();
+        fVacancy.ProcessEvent(rec);
+        fPerf->AddProcessEvent(PerfMonitor::Seconds(t0), rec.Size(), fVacancy.TotalCreated() - created);
+    } else {
+        fVacancy.ProcessEvent(rec);
+    }
+    if (fKMC) {
+        fKMC->OnEvent(rec);
+        fKMC->Advance(fKMC->GetParams().dtPerEvent_s);
+        fVacancy.UpdatePercolation(rec.eventId);
+    }
+    ++fCommitted;
+    if (fPotential) {
+        const int every = fPotential->GetParams().refreshEvery;
+        if (every > 0 && fCommitted % every == 0) {
+            // publish the field of the previous interval, then start the next
+            if (fPotential->FinishRefresh() && fKMC) fKMC->FieldChanged();
+            fPotential->BeginRefresh(fVacancy);
+        }
+    }
+    if (fCheckpointEvery > 0 && fCommitted % fCheckpointEvery == 0 && !fCheckpointPath.empty()) {
+        // State is consistent here: exactly the first fCommitted events are in.
+        // Only the copy happens under the lock; the caller writes it.
+        fSnapshotEvents = fEventBase + fCommitted;
+        fSnapshot = Checkpoint::Snapshot(fGrid, fVacancy, {fSnapshotEvents, fEventSeed});
+    }
+}
+
+void EventCommitter::WriteCheckpoint(std::string&& bytes, long long events) {
+    std::lock_guard<std::mutex> lock(fWriteMutex);
+    if (events <= fWrittenEvents) return;
+    if (Checkpoint::WriteBytes(fCheckpointPath, bytes)) {
+        fWrittenEvents = events;
+    } else {
+        G4cerr << "EventCommitter: cannot write checkpoint " << fCheckpointPath << G4endl;
+    }
+}
+
+void EventCommitter::Commit(EventRecord&& rec) {
+    std::string snapshot;
+    long long snapshotEvents = 0;
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+
+        if (rec.eventId == fNextId) {
+            // fast path (always taken in sequential mode): no parking
+            Apply(rec);
+            ++fNextId;
+        } else {
+            fPending.emplace(rec.eventId, std::move(rec));
+        }
+
+        // drain whatever became contiguous
+        for (auto it = fPending.begin(); it != fPending.end() && it->first == fNextId;
+             it = fPending.erase(it)) {
+            Apply(it->second);
+            ++fNextId;
+        }
+        snapshot.swap(fSnapshot);
+        snapshotEvents = fSnapshotEvents;
+    }
+    if (!snapshot.empty()) WriteCheckpoint(std::move(snapshot), snapshotEvents);
+}
+
+void EventCommitter::Flush() {
+    std::string snapshot;
+    long long snapshotEvents = 0;
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        for (auto& kv : fPending) {
+            Apply(kv.second);
+            fNextId = kv.first + 1;
+        }
+        fPending.clear();
+        snapshot.swap(fSnapshot);
+        snapshotEvents = fSnapshotEvents;
+    }
+    if (!snapshot.empty()) WriteCheckpoint(std::move(snapshot), snapshotEvents);
+}
+
+long long EventCommitter::Committed() const {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fCommitted;
+}
+
+size_t EventCommitter::Pending() const {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fPending.size();
+}
+
+bool EventCommitter::Stopped() const {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fVacancy.StopRequested();
+}
+
+long long EventCommitter::Dropped() const {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fDropped;
+}
@@ -0,0 +1,162 @@
+#include "LeakageCurrent.hh"
+#include "VoxelGrid.hh"
+#include "VacancyModel.hh"
+#include "PotentialSolver.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using hfo2units::nm;
+
+namespace {
+const double kHbar_Js = 1.054571817e-34;
+const double kMe_kg = 9.1093837015e-31;
+const double kQ_C = 1.602176634e-19;
+const double kBoltzmann_eV = 8.617333262e-5;
+
+double FermiDirac(double x) {   // x = (E - mu) / kT
+    return (x > 0.0) ? std::exp(-x) / (1.0 + std::exp(-x)) : 1.0 / (1.0 + std::exp(x));
+}
+}
+
+void LeakageCurrent::Build(const VoxelGrid& grid, const VacancyModel& vac,
+                           const PotentialSolver* field, double Vbottom_V, double Vtop_V) {
+    const int nx = grid.Nx(), ny = grid.Ny(), nz = grid.Nz();
+    const double hx = grid.Dx() / nm, hy = grid.Dy() / nm, hz = grid.Dz() / nm;
+    const size_t n = (size_t)nx * (size_t)ny * (size_t)nz;
+    if (field && (!field->IsConfigured() || field->Potential().size() != n)) field = nullptr;
+
+    const double kT = kBoltzmann_eV * fP.T_K;
+    const double kappa = std::sqrt(2.0 * fP.mEff * kMe_kg * fP.trapDepth_eV * kQ_C) / kHbar_Js * 1e-9;  // 1/nm
+    const double rc = fP.cutoffNm;
+
+    // Trap sites
+    fSites.clear();
+    fSiteOf.Configure(grid.Layout().Size(), -1);   // keyed like the vacancy counts
+    vac.VacCounts().ForEachChunk([&](size_t chunk, const VacancyModel::Count* cnt, size_t count) {
+        const size_t base = chunk * VacancyModel::kInitChunk;
+        for (size_t i = 0; i < count; ++i) {
+            if (cnt[i] == 0) continue;
+            fSiteOf[base + i] = (int32_t)fSites.size();
+            fSites.push_back(Site{base + i, (double)cnt[i], 0.0, 0.0, 0.0, 0.0, 0.0});
+        }
+    });
+
+    std::vector<double> level(fSites.size());
+    for (size_t s = 0; s < fSites.size(); ++s) {
+        const VoxelGrid::Index3 idx = grid.Unflatten(fSites[s].flat);
+        const double phi = field ? field->Potential(idx.ix, idx.iy, idx.iz)
+                                 : Vbottom_V + (Vtop_V - Vbottom_V) * (idx.iz + 0.5) / nz;
+        level[s] = fP.barrier_eV - fP.trapDepth_eV - phi;
+    }
+
+    // Electrode couplings (bottom: Si interface at iz = 0, top: iz = Nz-1 side)
+    for (size_t s = 0; s < fSites.size(); ++s) {
+        Site& t = fSites[s];
+        const int iz = grid.Unflatten(t.flat).iz;
+        const double dBot = (iz + 0.5) * hz, dTop = (nz - iz - 0.5) * hz;
+        if (dBot <= rc) {
+            const double w = fP.nuElectrode_Hz * std::exp(-2.0 * kappa * dBot);
+            const double occ = FermiDirac((level[s] + Vbottom_V) / kT);
+            t.cBot = w * occ;
+            t.eBot = w * (1.0 - occ);
+        }
+        if (dTop <= rc) {
+            const double w = fP.nuElectrode_Hz * std::exp(-2.0 * kappa * dTop);
+            const double occ = FermiDirac((level[s] + Vtop_V) / kT);
+            t.cTop = w * occ;
+            t.eTop = w * (1.0 - occ);
+        }
+    }
+
+    // Cell-list stencil: voxel offsets whose centre distance is within the cutoff
+    struct Offset { int dx, dy, dz; double tunnel; };
+    std::vector<Offset> stencil;
+    const int rx = (int)std::floor(rc / hx), ry = (int)std::floor(rc / hy), rz = (int)std::floor(rc / hz);
+    for (int dx = -rx; dx <= rx; ++dx) {
+        for (int dy = -ry; dy <= ry; ++dy) {
+            for (int dz = -rz; dz <= rz; ++dz) {
+                if (dx == 0 && dy == 0 && dz == 0) continue;
+                const double d = std::sqrt((dx * hx) * (dx * hx) + (dy * hy) * (dy * hy) + (dz * hz) * (dz * hz));
+                if (d <= rc) stencil.push_back(Offset{dx, dy, dz, fP.nuTrap_Hz * std::exp(-2.0 * kappa * d)});
+            }
+        }
+    }
+
+    // CSR pair rates, per trap; uphill hops pay the Boltzmann factor
+    fOffset.assign(1, 0);
+    fNbr.clear(); fOut.clear(); fIn.clear();
+    for (size_t s = 0; s < fSites.size(); ++s) {
+        const VoxelGrid::Index3 idx = grid.Unflatten(fSites[s].flat);
+        for (const auto& o : stencil) {
+            const int jx = idx.ix + o.dx, jy = idx.iy + o.dy, jz = idx.iz + o.dz;
+            if (jx < 0 || jx >= nx || jy < 0 || jy >= ny || jz < 0 || jz >= nz) continue;
+            const int32_t j = fSiteOf.Get(grid.Flatten(VoxelGrid::Index3{jx, jy, jz}));
+            if (j < 0) continue;
+            const double dE = level[j] - level[s];
+            fNbr.push_back(j);
+            fOut.push_back(o.tunnel * (dE > 0.0 ? std::exp(-dE / kT) : 1.0));
+            fIn.push_back(o.tunnel * (dE < 0.0 ? std::exp(dE / kT) : 1.0));
+        }
+        fOffset.push_back(fNbr.size());
+    }
+
+    fChange = 0.0;
+    fIterations = 0;
+}
+
+int LeakageCurrent::Solve() {
+    // Start from equilibrium with the electrodes where coupled
+    for (auto& t : fSites) {
+        const double c = t.cTop + t.cBot, e = t.eTop + t.eBot;
+        t.f = (c + e > 0.0) ? c / (c + e) : 0.0;
+    }
+
+    fIterations = 0;
+    fChange = 0.0;
+    while (fIterations < fP.maxIterations) {
+        fChange = 0.0;
+        for (size_t s = 0; s < fSites.size(); ++s) {
+            Site& t = fSites[s];
+            double in = t.cTop + t.cBot, out = t.eTop + t.eBot;
+            for (size_t k = fOffset[s]; k < fOffset[s + 1]; ++k) {
+                const Site& o = fSites[fNbr[k]];
+                in += o.n * o.f * fIn[k];
+                out += o.n * (1.0 - o.f) * fOut[k];
+            }
+            if (in + out <= 0.0) continue;   // isolated trap
+            // over-relaxed update, kept inside [0,1]; change relative to the
+            // smaller of f and 1-f since deep or shallow traps sit near 0 or 1
+            const double fNew = in / (in + out);
+            const double f = std::min(1.0, std::max(0.0, t.f + fP.omega * (fNew - t.f)));
+            const double scale = std::max(std::min(fNew, 1.0 - fNew), 1e-300);
+            fChange = std::max(fChange, std::fabs(fNew - t.f) / scale);
+            t.f = f;
+        }
+        ++fIterations;
+        if (fChange <= fP.tolerance) break;
+    }
+    return fIterations;
+}
+
+double LeakageCurrent::ElectrodeCurrent(bool top) const {
+    double rate = 0.0;   // electrons per second leaving the oxide
+    for (const auto& t : fSites) {
+        rate += top ? t.n * (t.f * t.eTop - (1.0 - t.f) * t.cTop)
+                    : t.n * (t.f * t.eBot - (1.0 - t.f) * t.cBot);
+    }
+    return kQ_C * rate;
+}
+
+double LeakageCurrent::CurrentTop_A() const { return ElectrodeCurrent(true); }
+double LeakageCurrent::CurrentBottom_A() const { return ElectrodeCurrent(false); }
+
+void LeakageCurrent::WriteSummaryRows(std::ostream& out) const {
+    out << "tat_sites," << Sites() << "\n";
+    out << "tat_pairs," << Pairs() << "\n";
+    out << "tat_cutoff_nm," << fP.cutoffNm << "\n";
+    out << "tat_iterations," << fIterations << "\n";
+    out << "tat_change," << fChange << "\n";
+    out << "tat_current_top_A," << CurrentTop_A() << "\n";
+    out << "tat_current_bottom_A," << CurrentBottom_A() << "\n";
+}
@@ -0,0 +1,57 @@
+#include "NpyWriter.hh"
+
+static constexpr size_t kNpyBufferBytes = 16u << 20;  // 16 MiB stdio buffer
+static constexpr size_t kNpyHeaderBytes = 128;         // magic + len + dict, padded
+
+std::string NpyWriter::Header() const {
+    std::string dict = "{'descr': '" + fDescr + "', 'fortran_order': False, 'shape': (";
+    for (size_t i = 0; i < fShape.size(); ++i) {
+        dict += std::to_string(fShape[i]);
+        if (fShape.size() == 1 || i + 1 < fShape.size()) dict += ",";
+        if (i + 1 < fShape.size()) dict += " ";
+    }
+    dict += "), }";
+
+    // magic(6) + version(2) + header_len(2) + dict, padded with spaces, '\n'-terminated
+    const size_t pre = 10;
+    std::string pad(kNpyHeaderBytes - pre - dict.size() - 1, ' ');
+    const uint16_t hlen = (uint16_t)(kNpyHeaderBytes - pre);
+
+    std::string h("\x93NUMPY\x01\x00", 8);
+    h += (char)(hlen & 0xff);
+    h += (char)(hlen >> 8);
+    h += dict + pad + "\n";
+    return h;
+}
+
+bool NpyWriter::Open(const std::string& path, const std::string& descr, const std::vector<size_t>& shape) {
+    Close();
+    fDescr = descr;
+    fShape = shape;
+
+    fFile = std::fopen(path.c_str(), "wb");
+    if (!fFile) return false;
+
+    fBuffer.resize(kNpyBufferBytes);
+    std::setvbuf(fFile, fBuffer.data(), _IOFBF, fBuffer.size());
+
+    const std::string h = Header();
+    std::fwrite(h.data(), 1, h.size(), fFile);
+    return true;
+}
+
+void NpyWriter::Write(const void* data, size_t bytes) {
+    if (fFile && bytes > 0) std::fwrite(data, 1, bytes, fFile);
+}
+
+bool NpyWriter::Close() {
+    if (!fFile) return true;
+
+    // rewrite the header in place (same length) with the final shape
+    const std::string h = Header();
+    bool ok = std::fseek(fFile, 0, SEEK_SET) == 0 &&
+              std::fwrite(h.data(), 1, h.size(), fFile) == h.size();
+    ok = (std::fclose(fFile) == 0) && ok;
+    fFile = nullptr;
+    return ok;
+}
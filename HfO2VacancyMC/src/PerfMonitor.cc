@@ -0,0 +1,123 @@
+#include "PerfMonitor.hh"
+
+#include "G4VPhysicalVolume.hh"
+#include "G4ios.hh"
+
+#include <fstream>
+#include <sstream>
+
+namespace {
+const char* const kPhaseName[PerfMonitor::kNPhases] = {
+    "transport", "scoring", "processEvent", "postRun", "export"};
+}
+
+void PerfMonitor::Histogram::Add(long long v) {
+    size_t bin = 0;
+    while (bin < 63 && (v >> bin) > 0) ++bin;
+    if (bins.size() <= bin) bins.resize(bin + 1, 0);
+    ++bins[bin];
+    ++n;
+    sum += (double)v;
+    if (v > max) max = v;
+}
+
+void PerfMonitor::Histogram::Write(std::ostream& out, const std::string& key) const {
+    out << key << "_mean," << (n > 0 ? sum / (double)n : 0.0) << "\n";
+    out << key << "_max," << max << "\n";
+    for (size_t b = 0; b < bins.size(); ++b) {
+        const long long lo = b == 0 ? 0 : 1LL << (b - 1);
+        const long long hi = b == 0 ? 0 : (1LL << b) - 1;
+        out << key << "_hist_" << lo << "_" << hi << "," << bins[b] << "\n";
+    }
+}
+
+void PerfMonitor::Reset() {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fStart = fLastReport = Clock::now();
+    fStepsByVolume.clear();
+    fSteps = fEvents = fLastSteps = fLastEvents = 0;
+    for (auto& t : fPhase_s) t = 0.0;
+    fTouched = Histogram{};
+    fCreated = Histogram{};
+}
+
+void PerfMonitor::EndEvent(const EventSample& sample) {
+    const double wall = Seconds(sample.start);
+    std::lock_guard<std::mutex> lock(fMutex);
+    for (const auto& s : sample.steps) {
+        if (s.second == 0) continue;
+        const std::string name = s.first ? std::string(s.first->GetName()) : "OutOfWorld";
+        fStepsByVolume[name] += s.second;
+        fSteps += s.second;
+    }
+    fPhase_s[kScoring] += sample.scoring_s;
+    fPhase_s[kTransport] += wall - sample.scoring_s;
+}
+
+void PerfMonitor::AddProcessEvent(double sec, size_t touched, long long created) {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fPhase_s[kProcessEvent] += sec;
+    fTouched.Add((long long)touched);
+    fCreated.Add(created);
+    ++fEvents;
+
+    if (fP.interval <= 0 || fEvents % fP.interval != 0) return;
+    const auto now = Clock::now();
+    const double dt = std::chrono::duration<double>(now - fLastReport).count();
+    if (dt > 0.0) {
+        G4cout << "Perf: " << fEvents << " events, " << (double)(fEvents - fLastEvents) / dt
+               << " events/s, " << (double)(fSteps - fLastSteps) / dt << " steps/s" << G4endl;
+    }
+    fLastReport = now;
+    fLastEvents = fEvents;
+    fLastSteps = fSteps;
+}
+
+void PerfMonitor::AddPhase(Phase phase, double sec) {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fPhase_s[phase] += sec;
+}
+
+long long PerfMonitor::Events() const {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fEvents;
+}
+
+long long PerfMonitor::Steps() const {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fSteps;
+}
+
+void PerfMonitor::WriteRows(std::ostream& out) const {
+    const double wall = Seconds(fStart);
+    out << "wall_s," << wall << "\n";
+    out << "events," << fEvents << "\n";
+    out << "steps," << fSteps << "\n";
+    out << "events_per_s," << (wall > 0.0 ? (double)fEvents / wall : 0.0) << "\n";
+    out << "steps_per_s," << (wall > 0.0 ? (double)fSteps / wall : 0.0) << "\n";
+    for (const auto& kv : fStepsByVolume) out << "steps_" << kv.first << "," << kv.second << "\n";
+    for (int p = 0; p < kNPhases; ++p) out << "time_" << kPhaseName[p] << "_s," << fPhase_s[p] << "\n";
+    fTouched.Write(out, "touched_per_event");
+    fCreated.Write(out, "created_per_event");
+}
+
+void PerfMonitor::Print() const {
+    std::ostringstream rows;
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        WriteRows(rows);
+    }
+    G4cout << "---- perf ----\n" << rows.str() << "--------------" << G4endl;
+}
+
+void PerfMonitor::WriteCSV(const std::string& path) const {
+    std::ofstream out(path);
+    out << "key,value\n";
+    std::lock_guard<std::mutex> lock(fMutex);
+    WriteRows(out);
+}
+
+void PerfMonitor::Dump() {
+    Print();
+    WriteCSV("perf.csv");
+}
@@ -0,0 +1,96 @@
+#include "PhysicsList.hh"
+
+#include "G4EmLivermorePhysics.hh"
+#include "G4EmStandardPhysics.hh"
+#include "G4EmStandardPhysics_option1.hh"
+#include "G4EmStandardPhysics_option2.hh"
+#include "G4EmStandardPhysics_option3.hh"
+#include "G4EmStandardPhysics_option4.hh"
+#include "G4EmParameters.hh"
+#include "G4StepLimiterPhysics.hh"
+#include "G4StateManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4ios.hh"
+
+#include <string>
+
+namespace {
+const char* const kOxideRegion = "HfO2Region";
+}
+
+PhysicsList::PhysicsList() {
+    fMessenger = new G4GenericMessenger(this, "/phys/", "EM physics per region");
+    fMessenger->DeclareMethod("em", &PhysicsList::SetEmMode,
+        "regional: Livermore in HfO2Region only | microelec: MicroElec in HfO2Region only | livermore: everywhere")
+        .SetCandidates("regional microelec livermore");
+    fMessenger->DeclareMethod("standardOption", &PhysicsList::SetStandardOption,
+        "G4EmStandardPhysics option used outside HfO2Region (regional and microelec modes)")
+        .SetCandidates("0 1 2 3 4");
+    fMessenger->DeclareMethod("tableCache", &PhysicsList::SetTableCache,
+        "Directory of cached physics tables, keyed by materials, cuts and EM settings (set before /run/initialize)");
+
+    BuildEm();
+    fStepLimiter = new G4StepLimiterPhysics();
+}
+
+PhysicsList::~PhysicsList() {
+    delete fMessenger;
+    delete fEm;
+    delete fStepLimiter;
+}
+
+void PhysicsList::BuildEm() {
+    delete fEm;
+    if (fEmMode == "livermore") {
+        fEm = new G4EmLivermorePhysics();
+    } else {
+        switch (fStandardOption) {
+            case 1:  fEm = new G4EmStandardPhysics_option1(); break;
+            case 2:  fEm = new G4EmStandardPhysics_option2(); break;
+            case 3:  fEm = new G4EmStandardPhysics_option3(); break;
+            case 4:  fEm = new G4EmStandardPhysics_option4(); break;
+            default: fEm = new G4EmStandardPhysics(); break;
+        }
+    }
+
+    fCache.SetTag("em=" + fEmMode + " standardOption=" + std::to_string(fStandardOption));
+
+    // Constructors reset G4EmParameters, so the region setup comes after them.
+    // Activated per region by G4EmModelActivator when the processes are built.
+    auto params = G4EmParameters::Instance();
+    params->SetMinEnergy(100.0*eV);
+    params->SetMaxEnergy(100.0*MeV);
+    if (fEmMode == "regional") {
+        params->AddPhysics(kOxideRegion, "G4EmLivermore");
+    } else if (fEmMode == "microelec") {
+        params->AddMicroElec(kOxideRegion);
+    }
+}
+
+void PhysicsList::SetEmMode(const G4String& mode) {
+    if (G4StateManager::GetStateManager()->GetCurrentState() != G4State_PreInit) {
+        G4cerr << "/phys/em: physics is already built; set it before /run/initialize" << G4endl;
+        return;
+    }
+    fEmMode = mode;
+    BuildEm();
+}
+
+void PhysicsList::SetStandardOption(G4int option) {
+    if (G4StateManager::GetStateManager()->GetCurrentState() != G4State_PreInit) {
+        G4cerr << "/phys/standardOption: physics is already built; set it before /run/initialize" << G4endl;
+        return;
+    }
+    fStandardOption = option;
+    BuildEm();
+}
+
+void PhysicsList::ConstructParticle() {
+    fEm->ConstructParticle();
+}
+
+void PhysicsList::ConstructProcess() {
+    AddTransportation();
+    fEm->ConstructProcess();
+    fStepLimiter->ConstructProcess();   // applies G4UserLimits (/det/hfo2MaxStepNm)
+}
@@ -0,0 +1,145 @@
+#include "PhysicsTableCache.hh"
+
+#include "G4VUserPhysicsList.hh"
+#include "G4Material.hh"
+#include "G4Element.hh"
+#include "G4IonisParamMat.hh"
+#include "G4RegionStore.hh"
+#include "G4Region.hh"
+#include "G4ProductionCuts.hh"
+#include "G4EmParameters.hh"
+#include "G4Version.hh"
+#include "G4ios.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const char* const kSignatureFile = "signature.txt";
+
+uint64_t Fnv1a(const std::string& s) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return in ? ss.str() : std::string();
+}
+
+bool MakeDirs(const std::string& path) {
+    for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+        const std::string part = path.substr(0, pos);
+        if (!part.empty() && ::mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        if (pos == std::string::npos) return true;
+    }
+}
+
+// Store directories are flat: files only
+void RemoveDir(const std::string& path) {
+    if (DIR* d = ::opendir(path.c_str())) {
+        while (const dirent* e = ::readdir(d)) {
+            const std::string name = e->d_name;
+            if (name != "." && name != "..") std::remove((path + "/" + name).c_str());
+        }
+        ::closedir(d);
+    }
+    ::rmdir(path.c_str());
+}
+
+double Since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+}
+
+PhysicsTableCache::PhysicsTableCache(G4VUserPhysicsList* list)
+    : fList(list), fStart(std::chrono::steady_clock::now()) {}
+
+G4bool PhysicsTableCache::Notify(G4ApplicationState requested) {
+    if (requested == G4State_Idle && !fPrepared) {
+        fPrepared = true;
+        Prepare();
+    } else if (requested == G4State_GeomClosed && !fDone) {
+        fDone = true;
+        StoreIfNew();
+    }
+    return true;
+}
+
+std::string PhysicsTableCache::Signature(const std::string& tag) {
+    std::ostringstream s;
+    s << std::setprecision(17);
+    s << "geant4 " << G4Version << "\n";
+    s << "physics " << tag << "\n";
+
+    for (const auto mat : *G4Material::GetMaterialTable()) {
+        s << "material " << mat->GetName() << " " << mat->GetDensity() << " "
+          << mat->GetIonisation()->GetMeanExcitationEnergy();
+        const auto& elements = *mat->GetElementVector();
+        const G4double* fractions = mat->GetFractionVector();
+        for (size_t i = 0; i < elements.size(); ++i) {
+            s << " " << elements[i]->GetName() << ":" << elements[i]->GetZ() << ":" << fractions[i];
+        }
+        s << "\n";
+    }
+
+    for (const auto region : *G4RegionStore::GetInstance()) {
+        s << "region " << region->GetName();
+        if (const auto cuts = region->GetProductionCuts()) {
+            for (const char* p : {"gamma", "e-", "e+", "proton"}) s << " " << cuts->GetProductionCut(p);
+        }
+        s << "\n";
+    }
+
+    G4EmParameters::Instance()->StreamInfo(s);
+    return s.str();
+}
+
+void PhysicsTableCache::Prepare() {
+    if (fRoot.empty()) return;
+    fSignature = Signature(fTag);
+    std::ostringstream name;
+    name << fRoot << "/" << std::hex << std::setw(16) << std::setfill('0') << Fnv1a(fSignature);
+    fEntry = name.str();
+
+    fHit = ReadFile(fEntry + "/" + kSignatureFile) == fSignature;
+    if (fHit) {
+        fList->SetPhysicsTableRetrieved(fEntry);
+        G4cout << "Physics table cache: retrieving from " << fEntry << G4endl;
+    } else {
+        G4cout << "Physics table cache: no entry for this setup, building (" << fEntry << ")" << G4endl;
+    }
+}
+
+void PhysicsTableCache::StoreIfNew() {
+    if (!fRoot.empty() && !fHit) {
+        // Private directory first, then one rename: readers see all or nothing
+        const std::string tmp = fEntry + ".tmp." + std::to_string((long)::getpid());
+        if (MakeDirs(tmp) && fList->StorePhysicsTable(tmp)) {
+            std::ofstream(tmp + "/" + kSignatureFile, std::ios::binary) << fSignature;
+            if (std::rename(tmp.c_str(), fEntry.c_str()) == 0) {
+                G4cout << "Physics table cache: stored " << fEntry << G4endl;
+            } else {
+                RemoveDir(tmp);   // another job stored it first
+            }
+        } else {
+            G4cerr << "Physics table cache: cannot store tables in " << tmp << G4endl;
+        }
+    }
+    G4cout << "Startup: " << Since(fStart) << " s to the first run (physics tables "
+           << (fHit ? "retrieved" : "built") << ")" << G4endl;
+}
@@ -0,0 +1,364 @@
+#include "PotentialSolver.hh"
+#include "VoxelGrid.hh"
+#include "VacancyModel.hh"
+#include "NpyWriter.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+using hfo2units::nm;
+
+PotentialSolver::~PotentialSolver() { Join(); }
+
+void PotentialSolver::Join() {
+    if (fRefresh.valid()) fRefresh.get();
+}
+
+void PotentialSolver::Configure(const VoxelGrid& grid) {
+    Join();
+    fLevels.clear();
+    fField.clear();
+    fFieldChunkMax.clear();
+
+    Level L;
+    L.nx = grid.Nx(); L.ny = grid.Ny(); L.nz = grid.Nz();
+    L.hx = grid.Dx() / nm; L.hy = grid.Dy() / nm; L.hz = grid.Dz() / nm;
+    fLevels.push_back(L);
+
+    // Coarsen x, y (cell pairs) down to 2x2 columns; z is resolved by the line smoother
+    while (fLevels.back().nx > 2 || fLevels.back().ny > 2) {
+        const Level& f = fLevels.back();
+        Level c;
+        c.nx = (f.nx + 1) / 2; c.ny = (f.ny + 1) / 2; c.nz = f.nz;
+        c.hx = (f.nx > 1) ? 2.0 * f.hx : f.hx;
+        c.hy = (f.ny > 1) ? 2.0 * f.hy : f.hy;
+        c.hz = f.hz;
+        fLevels.push_back(c);
+    }
+
+    for (auto& lv : fLevels) {
+        const size_t n = lv.Cells();
+        const size_t cols = (size_t)lv.nx * (size_t)lv.ny;
+        lv.eps.assign(n, fP.epsOxide);
+        lv.cx.assign(n, 0.0); lv.cy.assign(n, 0.0); lv.cz.assign(n, 0.0);
+        lv.cb.assign(cols, 0.0); lv.ct.assign(cols, 0.0);
+        lv.diag.assign(n, 0.0);
+        lv.phi.assign(n, 0.0); lv.rhs.assign(n, 0.0); lv.res.assign(n, 0.0);
+    }
+
+    // Initial guess: uniform field between the electrodes
+    Level& f = fLevels.front();
+    for (size_t i = 0; i < f.Cells(); ++i) {
+        const int iz = (int)(i % (size_t)f.nz);
+        f.phi[i] = fP.Vbottom_V + (fP.Vtop_V - fP.Vbottom_V) * (iz + 0.5) / f.nz;
+    }
+    fResidual = 0.0;
+    fSolves = 0;
+}
+
+void PotentialSolver::UpdatePermittivity(const VacancyModel& vac) {
+    fLayout = vac.Layout();
+    Level& f = fLevels.front();
+    const double cap = std::max<uint32_t>(1u, vac.CapPerVoxel());
+    const double de = fP.epsDefect - fP.epsOxide;
+    // The solver lattice is row-major; other storage layouts are decoded per voxel
+    const VoxelLayout& layout = vac.Layout();
+    vac.VacCounts().ForEachChunk([&](size_t chunk, const VacancyModel::Count* n, size_t count) {
+        const size_t first = chunk * VacancyModel::kInitChunk;
+        if (VoxelLayout::kRowMajor) {
+            double* eps = f.eps.data() + first;
+            for (size_t i = 0; i < count; ++i) {
+                eps[i] = fP.epsOxide + de * std::min(1.0, n[i] / cap);
+            }
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            int ix, iy, iz;
+            layout.Unflatten(first + i, ix, iy, iz);
+            if (ix >= f.nx || iy >= f.ny || iz >= f.nz) continue;
+            f.eps[f.Index(ix, iy, iz)] = fP.epsOxide + de * std::min(1.0, n[i] / cap);
+        }
+    });
+
+    // Coarse permittivity: mean of the children
+    for (size_t l = 1; l < fLevels.size(); ++l) {
+        const Level& fi = fLevels[l - 1];
+        Level& c = fLevels[l];
+        std::fill(c.eps.begin(), c.eps.end(), 0.0);
+        std::vector<int> kids((size_t)c.nx * (size_t)c.ny, 0);
+        for (int ix = 0; ix < fi.nx; ++ix) {
+            for (int iy = 0; iy < fi.ny; ++iy) {
+                const size_t col = (size_t)(ix / 2) * (size_t)c.ny + (size_t)(iy / 2);
+                ++kids[col];
+                for (int iz = 0; iz < fi.nz; ++iz) c.eps[c.Index(ix / 2, iy / 2, iz)] += fi.eps[fi.Index(ix, iy, iz)];
+            }
+        }
+        for (size_t i = 0; i < c.Cells(); ++i) c.eps[i] /= kids[i / (size_t)c.nz];
+    }
+
+    for (size_t l = 0; l < fLevels.size(); ++l) Assemble(fLevels[l], l == 0);
+}
+
+void PotentialSolver::Assemble(Level& L, bool fine) {
+    const double ax = L.hy * L.hz / L.hx;
+    const double ay = L.hx * L.hz / L.hy;
+    const double az = L.hx * L.hy / L.hz;
+    auto harmonic = [](double a, double b) { return 2.0 * a * b / (a + b); };
+
+    std::fill(L.diag.begin(), L.diag.end(), 0.0);
+    if (fine) std::fill(L.rhs.begin(), L.rhs.end(), 0.0);
+
+    for (int ix = 0; ix < L.nx; ++ix) {
+        for (int iy = 0; iy < L.ny; ++iy) {
+            for (int iz = 0; iz < L.nz; ++iz) {
+                const size_t i = L.Index(ix, iy, iz);
+                const double e = L.eps[i];
+                L.cx[i] = (ix + 1 < L.nx) ? ax * harmonic(e, L.eps[L.Index(ix + 1, iy, iz)]) : 0.0;
+                L.cy[i] = (iy + 1 < L.ny) ? ay * harmonic(e, L.eps[L.Index(ix, iy + 1, iz)]) : 0.0;
+                L.cz[i] = (iz + 1 < L.nz) ? az * harmonic(e, L.eps[i + 1]) : 0.0;
+
+                L.diag[i] += L.cx[i] + L.cy[i] + L.cz[i];
+                if (ix + 1 < L.nx) L.diag[L.Index(ix + 1, iy, iz)] += L.cx[i];
+                if (iy + 1 < L.ny) L.diag[L.Index(ix, iy + 1, iz)] += L.cy[i];
+                if (iz + 1 < L.nz) L.diag[i + 1] += L.cz[i];
+            }
+
+            // Electrodes sit half a cell below the first / above the last layer
+            const size_t col = (size_t)ix * (size_t)L.ny + (size_t)iy;
+            const size_t bottom = L.Index(ix, iy, 0), top = L.Index(ix, iy, L.nz - 1);
+            L.cb[col] = 2.0 * az * L.eps[bottom];
+            L.ct[col] = 2.0 * az * L.eps[top];
+            L.diag[bottom] += L.cb[col];
+            L.diag[top] += L.ct[col];
+            if (fine) {
+                L.rhs[bottom] += L.cb[col] * fP.Vbottom_V;
+                L.rhs[top] += L.ct[col] * fP.Vtop_V;
+            }
+        }
+    }
+}
+
+void PotentialSolver::SolveColumn(Level& L, int ix, int iy) {
+    thread_local std::vector<double> cp, dp;
+    cp.resize(L.nz);
+    dp.resize(L.nz);
+
+    const size_t yz = (size_t)L.ny * (size_t)L.nz;
+    const size_t base = L.Index(ix, iy, 0);
+
+    // Thomas algorithm on the z-line with the lateral neighbours frozen
+    for (int iz = 0; iz < L.nz; ++iz) {
+        const size_t i = base + iz;
+        double b = L.rhs[i];
+        if (ix + 1 < L.nx) b += L.cx[i] * L.phi[i + yz];
+        if (ix > 0)        b += L.cx[i - yz] * L.phi[i - yz];
+        if (iy + 1 < L.ny) b += L.cy[i] * L.phi[i + L.nz];
+        if (iy > 0)        b += L.cy[i - L.nz] * L.phi[i - L.nz];
+
+        const double lower = (iz > 0) ? -L.cz[i - 1] : 0.0;
+        const double upper = -L.cz[i];
+        const double denom = L.diag[i] - (iz > 0 ? lower * cp[iz - 1] : 0.0);
+        cp[iz] = upper / denom;
+        dp[iz] = (b - (iz > 0 ? lower * dp[iz - 1] : 0.0)) / denom;
+    }
+    L.phi[base + L.nz - 1] = dp[L.nz - 1];
+    for (int iz = L.nz - 2; iz >= 0; --iz) {
+        L.phi[base + iz] = dp[iz] - cp[iz] * L.phi[base + iz + 1];
+    }
+}
+
+void PotentialSolver::Smooth(Level& L, int sweeps) {
+    for (int s = 0; s < sweeps; ++s) {
+        for (int colour = 0; colour < 2; ++colour) {
+            #pragma omp parallel for schedule(static)
+            for (int ix = 0; ix < L.nx; ++ix) {
+                for (int iy = (ix + colour) & 1; iy < L.ny; iy += 2) SolveColumn(L, ix, iy);
+            }
+        }
+    }
+}
+
+double PotentialSolver::Residual(Level& L) {
+    const size_t yz = (size_t)L.ny * (size_t)L.nz;
+    double sum = 0.0;
+    #pragma omp parallel for schedule(static) reduction(+:sum)
+    for (int ix = 0; ix < L.nx; ++ix) {
+        for (int iy = 0; iy < L.ny; ++iy) {
+            for (int iz = 0; iz < L.nz; ++iz) {
+                const size_t i = L.Index(ix, iy, iz);
+                double Ap = L.diag[i] * L.phi[i];
+                if (ix + 1 < L.nx) Ap -= L.cx[i] * L.phi[i + yz];
+                if (ix > 0)        Ap -= L.cx[i - yz] * L.phi[i - yz];
+                if (iy + 1 < L.ny) Ap -= L.cy[i] * L.phi[i + L.nz];
+                if (iy > 0)        Ap -= L.cy[i - L.nz] * L.phi[i - L.nz];
+                if (iz + 1 < L.nz) Ap -= L.cz[i] * L.phi[i + 1];
+                if (iz > 0)        Ap -= L.cz[i - 1] * L.phi[i - 1];
+                L.res[i] = L.rhs[i] - Ap;
+                sum += L.res[i] * L.res[i];
+            }
+        }
+    }
+    return std::sqrt(sum);
+}
+
+void PotentialSolver::Restrict(const Level& fine, Level& coarse) {
+    // Finite-volume equations add up over the children
+    std::fill(coarse.rhs.begin(), coarse.rhs.end(), 0.0);
+    std::fill(coarse.phi.begin(), coarse.phi.end(), 0.0);
+    for (int ix = 0; ix < fine.nx; ++ix) {
+        for (int iy = 0; iy < fine.ny; ++iy) {
+            const size_t src = fine.Index(ix, iy, 0);
+            const size_t dst = coarse.Index(ix / 2, iy / 2, 0);
+            for (int iz = 0; iz < fine.nz; ++iz) coarse.rhs[dst + iz] += fine.res[src + iz];
+        }
+    }
+}
+
+void PotentialSolver::Prolong(const Level& coarse, Level& fine) {
+    #pragma omp parallel for schedule(static)
+    for (int ix = 0; ix < fine.nx; ++ix) {
+        for (int iy = 0; iy < fine.ny; ++iy) {
+            const size_t dst = fine.Index(ix, iy, 0);
+            const size_t src = coarse.Index(ix / 2, iy / 2, 0);
+            for (int iz = 0; iz < fine.nz; ++iz) fine.phi[dst + iz] += coarse.phi[src + iz];
+        }
+    }
+}
+
+void PotentialSolver::VCycle(size_t level) {
+    Level& L = fLevels[level];
+    if (level + 1 == fLevels.size()) {
+        Smooth(L, 20);   // at most 2x2 columns
+        return;
+    }
+    Smooth(L, fP.smoothSweeps);
+    Residual(L);
+    Restrict(L, fLevels[level + 1]);
+    VCycle(level + 1);
+    Prolong(fLevels[level + 1], L);
+    Smooth(L, fP.smoothSweeps);
+}
+
+int PotentialSolver::Solve(const VacancyModel& vac) {
+    if (fLevels.empty()) return 0;
+    Join();
+    UpdatePermittivity(vac);
+    const int cycles = Relax();
+    PublishField();
+    return cycles;
+}
+
+void PotentialSolver::BeginRefresh(const VacancyModel& vac) {
+    if (fLevels.empty()) return;
+    Join();   // refreshes never overlap
+    UpdatePermittivity(vac);
+    // The worker touches only the levels and fNext*: the model and the
+    // published field stay free for the caller
+    fRefresh = std::async(std::launch::async, [this] { return Relax(); });
+}
+
+bool PotentialSolver::FinishRefresh() {
+    if (!fRefresh.valid()) return false;
+    fRefresh.get();
+    PublishField();
+    return true;
+}
+
+int PotentialSolver::Relax() {
+    Level& f = fLevels.front();
+    double rhsNorm = 0.0;
+    for (double b : f.rhs) rhsNorm += b * b;
+    rhsNorm = std::sqrt(rhsNorm);
+    if (rhsNorm == 0.0) rhsNorm = 1.0;
+
+    int cycles = 0;
+    fResidual = Residual(f) / rhsNorm;
+    while (fResidual > fP.tolerance && cycles < fP.maxCycles) {
+        VCycle(0);
+        ++cycles;
+        fResidual = Residual(f) / rhsNorm;
+    }
+    ++fSolves;
+    BuildField();
+    return cycles;
+}
+
+void PotentialSolver::BuildField() {
+    // By the model's flat index, so consumers need no decoding; padding reads 0
+    const Level& L = fLevels.front();
+    const size_t n = fLayout.Size();
+    const size_t chunk = VacancyModel::kInitChunk;
+    fNextField.assign(n, 0.0f);
+    fNextChunkMax.assign((n + chunk - 1) / chunk, 0.0f);
+    #pragma omp parallel for schedule(static)
+    for (size_t c = 0; c < fNextChunkMax.size(); ++c) {
+        float emax = 0.0f;
+        for (size_t flat = c * chunk; flat < std::min(n, (c + 1) * chunk); ++flat) {
+            if (!fLayout.IsVoxel(flat)) continue;
+            int ix, iy, iz;
+            fLayout.Unflatten(flat, ix, iy, iz);
+            const float e = (float)FieldMagnitude(L.Index(ix, iy, iz));
+            fNextField[flat] = e;
+            emax = std::max(emax, e);
+        }
+        fNextChunkMax[c] = emax;
+    }
+}
+
+void PotentialSolver::PublishField() {
+    fField.swap(fNextField);
+    fFieldChunkMax.swap(fNextChunkMax);
+}
+
+double PotentialSolver::FieldMagnitude(size_t flat) const {
+    const Level& L = fLevels.front();
+    const int iz = (int)(flat % (size_t)L.nz);
+    const size_t col = flat / (size_t)L.nz;
+    const int iy = (int)(col % (size_t)L.ny);
+    const int ix = (int)(col / (size_t)L.ny);
+    const auto& p = L.phi;
+
+    auto slope = [&](size_t lo, size_t hi, double h) { return (p[hi] - p[lo]) / h; };
+    const size_t yz = (size_t)L.ny * (size_t)L.nz;
+
+    double ex = 0.0, ey = 0.0, ez = 0.0;
+    if (L.nx > 1) {
+        const size_t lo = (ix > 0) ? flat - yz : flat, hi = (ix + 1 < L.nx) ? flat + yz : flat;
+        ex = slope(lo, hi, L.hx * (double)((hi - lo) / yz));
+    }
+    if (L.ny > 1) {
+        const size_t lo = (iy > 0) ? flat - L.nz : flat, hi = (iy + 1 < L.ny) ? flat + L.nz : flat;
+        ey = slope(lo, hi, L.hy * (double)((hi - lo) / L.nz));
+    }
+    // z: the electrodes are half a cell beyond the outer layers
+    const double zlo = (iz > 0) ? p[flat - 1] : fP.Vbottom_V;
+    const double zhi = (iz + 1 < L.nz) ? p[flat + 1] : fP.Vtop_V;
+    const double dz = ((iz > 0) ? 1.0 : 0.5) + ((iz + 1 < L.nz) ? 1.0 : 0.5);
+    ez = (zhi - zlo) / (dz * L.hz);
+
+    return std::sqrt(ex * ex + ey * ey + ez * ez) * 1e9;   // V/nm -> V/m
+}
+
+void PotentialSolver::ExportNpy(const std::string& path) const {
+    if (fLevels.empty()) return;
+    const Level& L = fLevels.front();
+    NpyWriter out;
+    if (!out.Open(path, NpyWriter::Descr<double>(), {(size_t)L.nx, (size_t)L.ny, (size_t)L.nz})) return;
+    out.Write(L.phi.data(), L.phi.size());
+}
+
+void PotentialSolver::ExportCSV(const std::string& path) const {
+    if (fLevels.empty()) return;
+    const Level& L = fLevels.front();
+    std::ofstream out(path);
+    out << "ix,iy,iz,phi_V,E_V_per_m\n";
+    for (int ix = 0; ix < L.nx; ++ix) {
+        for (int iy = 0; iy < L.ny; ++iy) {
+            for (int iz = 0; iz < L.nz; ++iz) {
+                const size_t i = L.Index(ix, iy, iz);
+                out << ix << "," << iy << "," << iz << "," << L.phi[i] << "," << FieldMagnitude(i) << "\n";
+            }
+        }
+    }
+}
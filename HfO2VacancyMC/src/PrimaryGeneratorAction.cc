@@ -1,9 +1,11 @@
 #include "PrimaryGeneratorAction.hh"
+#include "DetectorConstruction.hh"
 
 #include "G4GeneralParticleSource.hh"
 #include "G4Event.hh"
+#include "Randomize.hh"
 
-PrimaryGeneratorAction::PrimaryGeneratorAction() {
+PrimaryGeneratorAction::PrimaryGeneratorAction(DetectorConstruction* det) : fDet(det) {
     fGPS = new G4GeneralParticleSource();
 }
 
@@ -12,6 +14,19 @@ PrimaryGeneratorAction::~PrimaryGeneratorAction() {
 }
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent) {
+    // Event-keyed seeding: the history depends only on (seed, global event
+    // number), not on the thread or on where a checkpointed run was split
+    const auto& committer = fDet->GetCommitter();
+    if (committer.EventSeed() != 0) {
+        const uint64_t event = (uint64_t)(committer.EventBase() + anEvent->GetEventID());
+        uint64_t z = committer.EventSeed() + 0x9E3779B97F4A7C15ull * (event + 1);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= (z >> 31);
+        const long seeds[3] = {(long)(z & 0x3FFFFFFF) + 1, (long)((z >> 32) & 0x3FFFFFFF) + 1, 0};
+        G4Random::setTheSeeds(seeds);
+    }
+
     // Generates one primary vertex according to current GPS settings
     fGPS->GeneratePrimaryVertex(anEvent);
 }
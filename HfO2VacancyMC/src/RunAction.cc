@@ -1,21 +1,233 @@
 #include "RunAction.hh"
 #include "DetectorConstruction.hh"
+#include "SublatticeKMC.hh"
+#include "Checkpoint.hh"
+#include "G4NistManager.hh"
+#include "G4EmParameters.hh"
 #include "G4Run.hh"
+#include "G4SystemOfUnits.hh"
 
-RunAction::RunAction(DetectorConstruction* det) : fDet(det) {}
+#include <fstream>
+#include <memory>
+
+RunAction::RunAction(DetectorConstruction* det) : fDet(det) {
+    fMessenger = new G4GenericMessenger(this, "/trace/", "Deposition trace control");
+    fMessenger->DeclareProperty("file", fTraceFile,
+        "Write per-event HfO2 deposits to this binary trace (empty disables); replay with HfO2VacancyReplay");
+
+    fOutMessenger = new G4GenericMessenger(this, "/out/", "Run output control");
+    fOutMessenger->DeclareProperty("format", fOutFormat,
+        "Per-voxel export format: npy | sparse | csv")
+        .SetCandidates("npy sparse csv");
+
+    fCkptMessenger = new G4GenericMessenger(this, "/ckpt/", "Checkpoint and restart");
+    fCkptMessenger->DeclareProperty("file", fCheckpointFile,
+        "Checkpoint file written every /ckpt/every events and at the end of the run (empty disables)");
+    fCkptMessenger->DeclareProperty("every", fCheckpointEvery, "Committed events between checkpoints (cut at the event, written outside the commit lock); 0 = end of run only");
+    fCkptMessenger->DeclareProperty("restart", fRestartFile,
+        "Continue from this checkpoint in the next run (beamOn the remaining events)");
+    fCkptMessenger->DeclareProperty("eventSeed", fEventSeed,
+        "Reseed every event from (seed, global event number); needed for exact restarts. 0 = Geant4 default seeding");
+}
+
+RunAction::~RunAction() {
+    delete fMessenger;
+    delete fOutMessenger;
+    delete fCkptMessenger;
+}
 
 void RunAction::BeginOfRunAction(const G4Run*) {
+    // Shared state is owned by the master; workers only hold event accumulators
+    if (!IsMaster()) return;
+
     fDet->GetVoxelGrid().ResetRunAccumulators();
-    fDet->GetVoxelGrid().ResetEventAccumulators();
     fDet->GetVacancyModel().ResetAndInit(fDet->GetVoxelGrid());
+    auto& committer = fDet->GetCommitter();
+    committer.Reset();
+    committer.SetEventBase(0);
+    committer.SetEventSeed(fEventSeed);
+
+    if (!fRestartFile.empty()) {
+        const auto info = Checkpoint::Read(fRestartFile, fDet->GetVoxelGrid(), fDet->GetVacancyModel());
+        committer.SetEventBase(info.eventsDone);
+        if (info.eventSeed != fEventSeed) {
+            G4cout << "RunAction: using the checkpoint's event seed " << info.eventSeed << G4endl;
+        }
+        committer.SetEventSeed(info.eventSeed);
+        G4cout << "Restarted from " << fRestartFile << " after " << info.eventsDone << " events" << G4endl;
+        fRestartFile.clear();
+    }
+    committer.SetCheckpoint(fCheckpointFile, fCheckpointEvery);
+
+    auto& substrate = fDet->GetSubstrateKiller();
+    substrate.ResetCounters();
+    if (substrate.Enabled()) {
+        substrate.Prepare(G4NistManager::Instance()->FindOrBuildMaterial("G4_Si"),
+                          G4EmParameters::Instance()->MinKinEnergy(),
+                          -fDet->GetHfO2ThicknessNm() * nm);
+    }
+
+    auto& perf = fDet->GetPerfMonitor();
+    perf.Reset();
+    committer.SetPerfMonitor(&perf);
+
+    // Interleaved kinetics: attach to the freshly initialized vacancy field
+    auto& kmc = fDet->GetKMC();
+    kmc.Detach();
+    if (kmc.GetParams().dtPerEvent_s > 0.0) {
+        kmc.Attach(fDet->GetVacancyModel());
+        fDet->GetCommitter().SetKMC(&kmc);
+    }
+
+    // In-run potential: solved once from the initial field, then refreshed by
+    // the committer; the KMC generation follows it
+    auto& field = fDet->GetPotentialSolver();
+    fDet->GetCommitter().SetPotentialSolver(nullptr);
+    kmc.SetField(nullptr);
+    if (field.GetParams().enabled) {
+        field.Configure(fDet->GetVoxelGrid());
+        if (field.GetParams().refreshEvery > 0) {
+            field.Solve(fDet->GetVacancyModel());
+            fDet->GetCommitter().SetPotentialSolver(&field);
+        }
+        kmc.SetField(&field);
+    }
+
+    if (!fTraceFile.empty()) {
+        const auto& grid = fDet->GetVoxelGrid();
+        DepositTraceHeader h;
+        h.nx = grid.Nx(); h.ny = grid.Ny(); h.nz = grid.Nz();
+        h.dx_nm = grid.Dx() / nm; h.dy_nm = grid.Dy() / nm; h.dz_nm = grid.Dz() / nm;
+        h.min_nm[0] = grid.Min().x() / nm;
+        h.min_nm[1] = grid.Min().y() / nm;
+        h.min_nm[2] = grid.Min().z() / nm;
+
+        if (fTrace.Open(fTraceFile, h)) {
+            fDet->GetCommitter().SetTraceWriter(&fTrace);
+        } else {
+            G4cerr << "RunAction: cannot open trace file " << fTraceFile << G4endl;
+        }
+    }
 }
 
 
 void RunAction::EndOfRunAction(const G4Run* run) {
+        if (!IsMaster()) return;
+
+        // Aborted runs can leave parked events behind a missing ID
+        auto& committer = fDet->GetCommitter();
+        committer.Flush();
+
+        // Irradiation state only: post-run kinetics below are not part of it
+        if (!fCheckpointFile.empty()) {
+            const Checkpoint::Info info{committer.EventBase() + committer.Committed(), committer.EventSeed()};
+            if (Checkpoint::Write(fCheckpointFile, fDet->GetVoxelGrid(), fDet->GetVacancyModel(), info)) {
+                G4cout << "Checkpoint " << fCheckpointFile << " at " << info.eventsDone << " events" << G4endl;
+            } else {
+                G4cerr << "RunAction: cannot write checkpoint " << fCheckpointFile << G4endl;
+            }
+        }
+
+        if (fTrace.IsOpen()) {
+            fDet->GetCommitter().SetTraceWriter(nullptr);
+            fTrace.Close();
+        }
+
+        auto& perf = fDet->GetPerfMonitor();
+        auto tPhase = PerfMonitor::Clock::now();
+
+        // Post-irradiation kinetics (vacancy migration after the beam)
+        auto& kmc = fDet->GetKMC();
+        const auto& kp = kmc.GetParams();
+        fDet->GetCommitter().SetKMC(nullptr);
+        std::unique_ptr<SublatticeKMC> parKmc;
+        if (kp.postTime_s > 0.0 && kp.threads > 0) {
+            parKmc.reset(new SublatticeKMC(kp));
+            parKmc->Attach(fDet->GetVacancyModel());
+            parKmc->Advance(kp.postTime_s);
+            G4cout << "KMC (" << parKmc->Threads() << " threads, " << parKmc->Sectors() << " sectors): t = "
+                   << parKmc->Time() << " s, " << parKmc->Steps() << " steps, parallel efficiency "
+                   << parKmc->ParallelEfficiency() << ", boundary conflicts "
+                   << parKmc->Conflicts() << "/" << parKmc->BoundaryEvents() << G4endl;
+        } else if (kmc.Enabled()) {
+            if (!kmc.IsAttached()) kmc.Attach(fDet->GetVacancyModel());
+            if (kp.postTime_s > 0.0) kmc.Advance(kp.postTime_s);
+        }
+        if (kmc.IsAttached()) {
+            G4cout << "KMC: t = " << kmc.Time() << " s, " << kmc.Steps() << " steps ("
+                   << kmc.Generated() << " generated, " << kmc.Recombined() << " recombined, "
+                   << kmc.Hops() << " hops)" << G4endl;
+        }
+
+        auto& vacancy = fDet->GetVacancyModel();
+        if (vacancy.GetParams().trackPercolation) {
+            if (vacancy.Percolated()) {
+                G4cout << "Percolation: spanning cluster at event " << vacancy.PercolationEvent();
+                if (vacancy.StopRequested()) {
+                    G4cout << ", run stopped (" << fDet->GetCommitter().Dropped() << " later events dropped)";
+                }
+                G4cout << G4endl;
+            } else {
+                G4cout << "Percolation: no spanning cluster during irradiation" << G4endl;
+            }
+            // state after the post-irradiation kinetics
+            if (kmc.IsAttached() || parKmc) {
+                G4cout << "Percolation after kinetics: "
+                       << (vacancy.RebuildPercolation() ? "spanning" : "not spanning") << G4endl;
+            }
+        }
+
+        auto& field = fDet->GetPotentialSolver();
+        fDet->GetCommitter().SetPotentialSolver(nullptr);
+        if (field.IsConfigured() && field.GetParams().enabled) {
+            const int cycles = field.Solve(fDet->GetVacancyModel());
+            G4cout << "Potential: " << cycles << " V-cycles, relative residual " << field.Residual()
+                   << " (" << field.Solves() << " solves this run)" << G4endl;
+            if (fOutFormat == "csv") field.ExportCSV("hfO2_potential.csv");
+            else field.ExportNpy("hfO2_potential.npy");
+        }
+
+        auto& tat = fDet->GetLeakageCurrent();
+        if (tat.GetParams().enabled) {
+            const auto& fp = field.GetParams();
+            tat.Build(fDet->GetVoxelGrid(), fDet->GetVacancyModel(),
+                      (field.IsConfigured() && fp.enabled) ? &field : nullptr, fp.Vbottom_V, fp.Vtop_V);
+            const int sweeps = tat.Solve();
+            G4cout << "TAT current: " << tat.CurrentTop_A() << " A (" << tat.Sites() << " trap sites, "
+                   << tat.Pairs() << " pairs within " << tat.GetParams().cutoffNm << " nm, "
+                   << sweeps << " sweeps)" << G4endl;
+        }
+
+        perf.AddPhase(PerfMonitor::kPostRun, PerfMonitor::Seconds(tPhase));
+        tPhase = PerfMonitor::Clock::now();
+
         const auto& grid    = fDet->GetVoxelGrid();
         const auto& vac     = fDet->GetVacancyModel();
 
-        grid.ExportEdepCSV("hfO2_edep_voxels.csv");
-        vac.ExportVacancyCSV("hfO2_vacancy_map.csv", grid);
-        vac.ExportSummaryCSV("hfO2_vacancy_summary.csv", run->GetNumberOfEvent());
+        G4cout << "Voxel state memory: "
+               << (grid.MemoryBytes() + vac.MemoryBytes()) / (1024.0*1024.0) << " MiB for "
+               << (size_t)grid.Nx()*grid.Ny()*grid.Nz() << " voxels" << G4endl;
+
+        if (fOutFormat == "csv") {
+            grid.ExportEdepCSV(fOutCsv);
+            vac.ExportVacancyCSV("hfO2_vacancy_map.csv", grid);
+        } else if (fOutFormat == "sparse") {
+            grid.ExportEdepNpySparse("hfO2_edep_voxels_sparse");
+            vac.ExportVacancyNpySparse("hfO2_vacancy");
+        } else {
+            grid.ExportEdepNpy("hfO2_edep_voxels.npy");
+            vac.ExportVacancyNpy("hfO2_vacancy");
+        }
+        vac.ExportSummaryCSV("hfO2_vacancy_summary.csv", committer.EventBase() + run->GetNumberOfEvent());
+        const auto& substrate = fDet->GetSubstrateKiller();
+        if (kmc.IsAttached() || parKmc || tat.GetParams().enabled || substrate.Enabled()) {
+            std::ofstream summary("hfO2_vacancy_summary.csv", std::ios::app);
+            if (substrate.Enabled()) substrate.WriteSummaryRows(summary);
+            if (kmc.IsAttached()) kmc.WriteSummaryRows(summary);
+            if (parKmc) parKmc->WriteSummaryRows(summary);
+            if (tat.GetParams().enabled) tat.WriteSummaryRows(summary);
+        }
+
+        perf.AddPhase(PerfMonitor::kExport, PerfMonitor::Seconds(tPhase));
+        if (perf.Enabled()) perf.Dump();   // perf.csv next to the summary
 }
@@ -0,0 +1,26 @@
+#include "StackingAction.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4Track.hh"
+#include "G4Electron.hh"
+
+StackingAction::StackingAction(DetectorConstruction* det) : fDet(det) {}
+
+G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track* track) {
+    auto& killer = fDet->GetSubstrateKiller();
+    if (!killer.Enabled() || track->GetParentID() == 0) return fUrgent;
+    if (track->GetParticleDefinition() != G4Electron::Definition()) return fUrgent;
+    if (track->GetVolume() != fDet->GetSiPV()) return fUrgent;
+
+    const auto ekin = track->GetKineticEnergy();
+    if (killer.Unreachable(ekin, killer.Depth(track->GetPosition()))) {
+        killer.CountKilled(false);
+        return fKill;
+    }
+
+    G4double weight = track->GetWeight();
+    if (!killer.Roulette(ekin, weight)) return fKill;
+    // Survivor carries the roulette weight (the track is not yet stacked)
+    if (weight != track->GetWeight()) const_cast<G4Track*>(track)->SetWeight(weight);
+    return fUrgent;
+}
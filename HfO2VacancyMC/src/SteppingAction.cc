@@ -1,28 +1,64 @@
 #include "SteppingAction.hh"
 #include "DetectorConstruction.hh"
+#include "EventAction.hh"
 
 #include "G4Step.hh"
 #include "G4Track.hh"
 #include "G4LogicalVolume.hh"
 #include "G4VPhysicalVolume.hh"
+#include "G4Electron.hh"
 
-SteppingAction::SteppingAction(DetectorConstruction* det) : fDet(det) {}
+SteppingAction::SteppingAction(DetectorConstruction* det, EventAction* evt)
+    : fDet(det), fEvt(evt) {}
 
 void SteppingAction::UserSteppingAction(const G4Step* step) {
+    if (!fDet->GetPerfMonitor().Enabled()) {
+        Score(step);
+        KillInSubstrate(step);
+        return;
+    }
+
+    // Instrumented: count every step by volume and time the scoring
+    const auto t0 = PerfMonitor::Clock::now();
+    auto& sample = fEvt->GetPerfSample();
+    sample.CountStep(step->GetPreStepPoint()->GetPhysicalVolume());
+    Score(step);
+    KillInSubstrate(step);
+    sample.scoring_s += PerfMonitor::Seconds(t0);
+}
+
+void SteppingAction::Score(const G4Step* step) {
     const auto edep = step->GetTotalEnergyDeposit();
     if (edep <= 0.0) return;
 
+    // Only score inside HfO2 volume (pointer compare, no name lookup per step)
     const auto pre = step->GetPreStepPoint();
-    const auto vol = pre->GetTouchableHandle()->GetVolume();
-    if (!vol) return;
-
-    // Only score inside HfO2 volume
-    if (vol->GetName() != "HfO2PV") return;
+    if (pre->GetPhysicalVolume() != fDet->GetHfO2PV()) return;
 
-    // Use mid-step position for binning
     const auto p1 = pre->GetPosition();
     const auto p2 = step->GetPostStepPoint()->GetPosition();
-    const auto pmid = 0.5*(p1 + p2);
+    const auto weight = step->GetTrack()->GetWeight();
+    auto& grid = fEvt->GetEventGrid();
+
+    // Thread-local event grid, committed to the shared grid at end of event
+    if (fDet->GetSplitSteps()) {
+        grid.AddSegment(p1, p2, edep, weight);   // split by path length per voxel
+    } else {
+        grid.AddEdep(0.5*(p1 + p2), edep, weight);   // mid-step position
+    }
+}
+
+void SteppingAction::KillInSubstrate(const G4Step* step) {
+    auto& killer = fDet->GetSubstrateKiller();
+    if (!killer.Enabled()) return;
+
+    const auto post = step->GetPostStepPoint();
+    if (post->GetPhysicalVolume() != fDet->GetSiPV()) return;
+    const auto track = step->GetTrack();
+    if (track->GetParticleDefinition() != G4Electron::Definition()) return;
 
-    fDet->GetVoxelGrid().AddEdep(pmid, edep);
+    if (killer.Unreachable(post->GetKineticEnergy(), killer.Depth(post->GetPosition()))) {
+        track->SetTrackStatus(fStopAndKill);
+        killer.CountKilled(true);
+    }
 }
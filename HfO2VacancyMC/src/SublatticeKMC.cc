@@ -0,0 +1,311 @@
+#include "SublatticeKMC.hh"
+#include "VacancyModel.hh"
+#include "ThreadPool.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+const int kDx[6] = {+1,-1, 0, 0, 0, 0};
+const int kDy[6] = { 0, 0,+1,-1, 0, 0};
+const int kDz[6] = { 0, 0, 0, 0,+1,-1};
+}
+
+SublatticeKMC::SublatticeKMC(const VacancyKMC::Params& p) : fP(p) {
+    fP.threads = std::max(1, fP.threads);
+    fP.sectorX = std::max(1, fP.sectorX);
+    fP.sectorY = std::max(1, fP.sectorY);
+    fPool.reset(new ThreadPool((unsigned)fP.threads));
+}
+
+SublatticeKMC::~SublatticeKMC() = default;
+
+unsigned SublatticeKMC::Threads() const { return fPool->Size(); }
+
+void SublatticeKMC::Decode(const Sector& s, size_t local, int& ix, int& iy, int& iz) const {
+    const size_t sy = (size_t)(s.y1 - s.y0);
+    iz = (int)(local % (size_t)fNz);
+    const size_t col = local / (size_t)fNz;
+    iy = s.y0 + (int)(col % sy);
+    ix = s.x0 + (int)(col / sy);
+}
+
+void SublatticeKMC::Attach(VacancyModel& model) {
+    fVac = VacancyKMC::DenseCounts(fP, model);
+    fModel = &model;
+    fCap = model.CapPerVoxel();
+    fNx = model.Nx();
+    fNy = model.Ny();
+    fNz = model.Nz();
+    fLayout = model.Layout();
+    VacancyKMC::Coefficients(fP, fRg, fRr, fRd);
+
+    fTime = 0.0;
+    fConflicts = 0;
+    fPhaseWall_s = 0.0;
+
+    const int nsx = (fNx + fP.sectorX - 1) / fP.sectorX;
+    const int nsy = (fNy + fP.sectorY - 1) / fP.sectorY;
+    fSectors.clear();
+    fSectors.resize((size_t)nsx * (size_t)nsy);
+    for (auto& c : fByColour) c.clear();
+
+    for (int sx = 0; sx < nsx; ++sx) {
+        for (int sy = 0; sy < nsy; ++sy) {
+            const size_t index = (size_t)sx * (size_t)nsy + (size_t)sy;
+            auto& s = fSectors[index];
+            s.x0 = sx * fP.sectorX;  s.x1 = std::min(fNx, s.x0 + fP.sectorX);
+            s.y0 = sy * fP.sectorY;  s.y1 = std::min(fNy, s.y0 + fP.sectorY);
+            fByColour[(sx & 1) | ((sy & 1) << 1)].push_back(index);
+        }
+    }
+
+    fPool->ParallelFor(fSectors.size(), [this](size_t i) { InitSector(fSectors[i], i); });
+}
+
+void SublatticeKMC::InitSector(Sector& s, size_t index) {
+    // splitmix64 of (seed, sector): streams independent of the thread count
+    uint64_t z = fP.seed + 0x9E3779B97F4A7C15ull * (index + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    s.rng.seed(z ^ (z >> 31));
+
+    const size_t n = (size_t)(s.x1 - s.x0) * (size_t)(s.y1 - s.y0) * (size_t)fNz;
+    s.queue.Begin(n, fRg * fCap);
+    for (size_t local = 0; local < n; ++local) {
+        int ix, iy, iz;
+        Decode(s, local, ix, iy, iz);
+        if (fVac[Flat(ix, iy, iz)] == 0) s.queue.AddPooled(local);
+        else s.queue.AddTracked(local, ChannelRate(ix, iy, iz));
+    }
+    s.queue.Build(s.rng);
+    s.outbox.clear();
+    s.transit.clear();
+    s.steps = s.generated = s.recombined = s.hops = s.boundary = 0;
+    s.busy_s = 0.0;
+}
+
+double SublatticeKMC::ChannelRate(int ix, int iy, int iz, uint32_t transit) const {
+    const uint32_t held = fVac[Flat(ix, iy, iz)];
+    const uint32_t n = held - transit;
+    const uint32_t free = (held < fCap) ? fCap - held : 0;
+    double rate = fRg * free + fRr * n;
+    if (n > 0) {
+        int open = 0;
+        for (int k = 0; k < 6; ++k) {
+            const int jx = ix + kDx[k], jy = iy + kDy[k], jz = iz + kDz[k];
+            if (jx < 0 || jx >= fNx || jy < 0 || jy >= fNy || jz < 0 || jz >= fNz) continue;
+            open += (fVac[Flat(jx, jy, jz)] < fCap);
+        }
+        rate += fRd * n * open;
+    }
+    return rate;
+}
+
+void SublatticeKMC::Reschedule(Sector& s, size_t local, double now) {
+    int ix, iy, iz;
+    Decode(s, local, ix, iy, iz);
+    if (fVac[Flat(ix, iy, iz)] == 0) s.queue.Pool(local, now, s.rng);
+    else s.queue.Track(local, ChannelRate(ix, iy, iz, Transit(s, local)), now, s.rng);
+}
+
+void SublatticeKMC::RescheduleAround(Sector& s, int ix, int iy, int iz, double now) {
+    if (Inside(s, ix, iy)) Reschedule(s, Local(s, ix, iy, iz), now);
+    for (int k = 0; k < 6; ++k) {
+        const int jx = ix + kDx[k], jy = iy + kDy[k], jz = iz + kDz[k];
+        if (jz < 0 || jz >= fNz || !Inside(s, jx, jy)) continue;
+        Reschedule(s, Local(s, jx, jy, jz), now);
+    }
+}
+
+size_t SublatticeKMC::FirePool(Sector& s, size_t block) {
+    const size_t local = s.queue.Pick(block, [&](size_t id) {
+        int ix, iy, iz;
+        Decode(s, id, ix, iy, iz);
+        return fVac[Flat(ix, iy, iz)] == 0;
+    }, s.rng);
+    int ix, iy, iz;
+    Decode(s, local, ix, iy, iz);
+    fVac[Flat(ix, iy, iz)] = 1;
+    ++s.generated;
+    return local;
+}
+
+void SublatticeKMC::Fire(Sector& s, size_t ch) {
+    const double now = s.queue.Key(ch);
+    ++s.steps;
+
+    int ix, iy, iz;
+    if (s.queue.IsPool(ch)) {
+        s.queue.Redraw(ch, s.queue.PoolRate(ch), now, s.rng);
+        Decode(s, FirePool(s, ch), ix, iy, iz);
+        RescheduleAround(s, ix, iy, iz, now);
+        return;
+    }
+
+    const size_t local = s.queue.Voxel(ch);
+    Decode(s, local, ix, iy, iz);
+    const size_t flat = Flat(ix, iy, iz);
+    const uint32_t held = fVac[flat];
+    const uint32_t n = held - Transit(s, local);
+    const uint32_t free = (held < fCap) ? fCap - held : 0;
+    double u = ChannelQueue::Uniform(s.rng) * s.queue.Rate(ch);
+
+    int hopK = -1;
+    const double gen = fRg * free;
+    const double rec = fRr * n;
+    if (u < gen) {
+        fVac[flat] = held + 1;
+        ++s.generated;
+    } else if ((u -= gen) < rec) {
+        fVac[flat] = held - 1;
+        ++s.recombined;
+    } else {
+        u -= rec;
+        const double hop = fRd * n;
+        for (int k = 0; k < 6; ++k) {
+            const int jx = ix + kDx[k], jy = iy + kDy[k], jz = iz + kDz[k];
+            if (jx < 0 || jx >= fNx || jy < 0 || jy >= fNy || jz < 0 || jz >= fNz) continue;
+            if (fVac[Flat(jx, jy, jz)] >= fCap) continue;
+            hopK = k;
+            if (u < hop) break;
+            u -= hop;
+        }
+        if (hopK >= 0) {
+            const int jx = ix + kDx[hopK], jy = iy + kDy[hopK], jz = iz + kDz[hopK];
+            if (Inside(s, jx, jy)) {
+                fVac[flat] = held - 1;
+                fVac[Flat(jx, jy, jz)] += 1;
+                ++s.hops;
+            } else {
+                // the target belongs to an idle sector: deliver after the phase,
+                // the source keeps the slot until then
+                s.outbox.emplace_back(flat, Flat(jx, jy, jz));
+                ++s.transit[local];
+                ++s.boundary;
+            }
+        } else if (rec > 0.0) {
+            fVac[flat] = held - 1;
+            ++s.recombined;
+        }
+    }
+
+    if (fVac[flat] > 0) s.queue.Redraw(ch, ChannelRate(ix, iy, iz, Transit(s, local)), now, s.rng);
+    RescheduleAround(s, ix, iy, iz, now);
+    if (hopK >= 0) RescheduleAround(s, ix + kDx[hopK], iy + kDy[hopK], iz + kDz[hopK], now);
+}
+
+void SublatticeKMC::RunPhase(Sector& s, double tEnd) {
+    const auto t0 = std::chrono::steady_clock::now();
+
+    // Neighbouring sectors moved since this one last ran: rates can change
+    // from outside in the edge columns (incoming hops) and their neighbours
+    for (int ix = s.x0; ix < s.x1; ++ix) {
+        for (int iy = s.y0; iy < s.y1; ++iy) {
+            if (ix - s.x0 >= 2 && s.x1 - 1 - ix >= 2 && iy - s.y0 >= 2 && s.y1 - 1 - iy >= 2) continue;
+            for (int iz = 0; iz < fNz; ++iz) Reschedule(s, Local(s, ix, iy, iz), fTime);
+        }
+    }
+
+    while (!s.queue.Empty() && s.queue.TopKey() <= tEnd) Fire(s, s.queue.Top());
+
+    s.busy_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void SublatticeKMC::Reconcile(const std::vector<size_t>& sectors) {
+    for (size_t i : sectors) {
+        auto& s = fSectors[i];
+        for (const auto& h : s.outbox) {
+            if (fVac[h.second] < fCap) {
+                fVac[h.second] += 1;
+                fVac[h.first] -= 1;
+                ++s.hops;
+            } else {
+                // rejected: the vacancy stays in the slot it held at its source
+                ++fConflicts;
+            }
+        }
+        // the source rates change with it: the shell reschedule of the next
+        // phase picks them up
+        s.outbox.clear();
+        s.transit.clear();
+    }
+}
+
+long long SublatticeKMC::Advance(double dt_s) {
+    if (!fVac || !(dt_s > 0.0)) return 0;
+
+    const long long before = Steps();
+    const double tStop = fTime + dt_s;
+    while (fTime < tStop) {
+        const double tEnd = std::min(tStop, fTime + fP.window_s);
+        for (const auto& colour : fByColour) {
+            const auto t0 = std::chrono::steady_clock::now();
+            fPool->ParallelFor(colour.size(), [&](size_t i) { RunPhase(fSectors[colour[i]], tEnd); });
+            fPhaseWall_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            Reconcile(colour);
+        }
+        fTime = tEnd;
+    }
+    // Sectors ran concurrently, so the model's neighbour field is rebuilt instead
+    if (Steps() != before) fModel->CountsChanged();
+    return Steps() - before;
+}
+
+long long SublatticeKMC::Steps() const {
+    long long n = 0;
+    for (const auto& s : fSectors) n += s.steps;
+    return n;
+}
+
+long long SublatticeKMC::Generated() const {
+    long long n = 0;
+    for (const auto& s : fSectors) n += s.generated;
+    return n;
+}
+
+long long SublatticeKMC::Recombined() const {
+    long long n = 0;
+    for (const auto& s : fSectors) n += s.recombined;
+    return n;
+}
+
+long long SublatticeKMC::Hops() const {
+    long long n = 0;
+    for (const auto& s : fSectors) n += s.hops;
+    return n;
+}
+
+long long SublatticeKMC::BoundaryEvents() const {
+    long long n = 0;
+    for (const auto& s : fSectors) n += s.boundary;
+    return n;
+}
+
+double SublatticeKMC::ParallelEfficiency() const {
+    double busy = 0.0;
+    for (const auto& s : fSectors) busy += s.busy_s;
+    const double available = fPhaseWall_s * Threads();
+    return available > 0.0 ? busy / available : 0.0;
+}
+
+double SublatticeKMC::ConflictRate() const {
+    const long long b = BoundaryEvents();
+    return b > 0 ? (double)fConflicts / (double)b : 0.0;
+}
+
+void SublatticeKMC::WriteSummaryRows(std::ostream& out) const {
+    out << "kmcpar_threads," << Threads() << "\n";
+    out << "kmcpar_sectors," << Sectors() << "\n";
+    out << "kmcpar_window_s," << fP.window_s << "\n";
+    out << "kmcpar_time_s," << fTime << "\n";
+    out << "kmcpar_steps," << Steps() << "\n";
+    out << "kmcpar_generated," << Generated() << "\n";
+    out << "kmcpar_recombined," << Recombined() << "\n";
+    out << "kmcpar_hops," << Hops() << "\n";
+    out << "kmcpar_boundary_events," << BoundaryEvents() << "\n";
+    out << "kmcpar_conflicts," << fConflicts << "\n";
+    out << "kmcpar_conflict_rate," << ConflictRate() << "\n";
+    out << "kmcpar_parallel_efficiency," << ParallelEfficiency() << "\n";
+}
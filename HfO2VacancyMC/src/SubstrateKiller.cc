@@ -0,0 +1,80 @@
+#include "SubstrateKiller.hh"
+
+#include "G4EmCalculator.hh"
+#include "G4Electron.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace {
+const int kBins = 256;   // log-spaced energies of the range table
+}
+
+void SubstrateKiller::Prepare(const G4Material* si, G4double minEnergy, G4double interfaceZ) {
+    fInterfaceZ = interfaceZ;
+    fEnergy.clear();
+    fRange.clear();
+    const G4double eMax = fP.maxEnergy_keV * keV;
+    if (!si || minEnergy <= 0.0 || eMax <= minEnergy) return;
+
+    // CSDA range by trapezoidal integration of 1/S(E); below the table the
+    // electron is not tracked anyway, its range is taken as E/S(E)
+    G4EmCalculator calc;
+    const auto electron = G4Electron::Definition();
+    fLogE0 = std::log(minEnergy);
+    fInvDlogE = (kBins - 1) / (std::log(eMax) - fLogE0);
+    G4double prevE = minEnergy;
+    G4double prevInv = 1.0 / calc.ComputeTotalDEDX(minEnergy, electron, si);
+    G4double range = minEnergy * prevInv;
+    fEnergy.push_back(prevE);
+    fRange.push_back(range);
+    for (int i = 1; i < kBins; ++i) {
+        const G4double e = std::exp(fLogE0 + i / fInvDlogE);
+        const G4double inv = 1.0 / calc.ComputeTotalDEDX(e, electron, si);
+        range += 0.5 * (inv + prevInv) * (e - prevE);
+        fEnergy.push_back(e);
+        fRange.push_back(range);
+        prevE = e;
+        prevInv = inv;
+    }
+}
+
+G4double SubstrateKiller::CsdaRange(G4double ekin) const {
+    if (fEnergy.empty() || ekin >= fEnergy.back()) return DBL_MAX;
+    if (ekin <= fEnergy.front()) return fRange.front() * ekin / fEnergy.front();
+    const G4double x = (std::log(ekin) - fLogE0) * fInvDlogE;
+    const size_t i = std::min(fEnergy.size() - 2, (size_t)x);
+    const G4double t = (ekin - fEnergy[i]) / (fEnergy[i + 1] - fEnergy[i]);
+    return fRange[i] + t * (fRange[i + 1] - fRange[i]);
+}
+
+bool SubstrateKiller::Roulette(G4double ekin, G4double& weight) {
+    if (!fP.roulette || ekin >= fP.rouletteEnergy_keV * keV ||
+        fP.rouletteSurvival <= 0.0 || fP.rouletteSurvival >= 1.0) {
+        return true;
+    }
+    if (G4UniformRand() >= fP.rouletteSurvival) {
+        ++fRouletteKilled;
+        return false;
+    }
+    ++fRouletteSurvived;
+    weight /= fP.rouletteSurvival;
+    return true;
+}
+
+void SubstrateKiller::ResetCounters() {
+    fKilledAtBirth = 0;
+    fKilledInFlight = 0;
+    fRouletteKilled = 0;
+    fRouletteSurvived = 0;
+}
+
+void SubstrateKiller::WriteSummaryRows(std::ostream& out) const {
+    out << "substrate_killed_at_birth," << fKilledAtBirth << "\n";
+    out << "substrate_killed_in_flight," << fKilledInFlight << "\n";
+    out << "substrate_roulette_killed," << fRouletteKilled << "\n";
+    out << "substrate_roulette_survived," << fRouletteSurvived << "\n";
+}
@@ -0,0 +1,216 @@
+#include "VacancyBatch.hh"
+#include "VoxelGrid.hh"
+#include "EventRecord.hh"
+
+#include <fstream>
+#include <cmath>
+#include <stdexcept>
+
+VacancyBatch::VacancyBatch(std::vector<VacancyModel::Params> lanes)
+    : fParams(std::move(lanes)), fK(fParams.size())
+{
+    if (fK == 0) throw std::runtime_error("VacancyBatch: no parameter lanes.");
+
+    fW.resize(fK);
+    fEaBase.resize(fK);
+    fEaFast.resize(fK);
+    fFastEverywhere.resize(fK);
+    fBankInvTau.resize(fK);
+    for (size_t l = 0; l < fK; ++l) {
+        fW[l] = fParams[l].W_eV;
+        fEaBase[l] = fParams[l].Ea_base_eV;
+        fEaFast[l] = fParams[l].Ea_fast_eV;
+        fFastEverywhere[l] = fParams[l].fastOnlyNearSeed ? 0 : 1;
+        fBankInvTau[l] = fParams[l].bankRelaxEvents > 0.0 ? 1.0 / fParams[l].bankRelaxEvents : 0.0;
+        fBankRelax = fBankRelax || fBankInvTau[l] > 0.0;
+    }
+    fCap.assign(fK, 0);
+    fLambda.assign(fK, 0.0);
+    fSeedCaptured.assign(fK, 0);
+    fTotalCreated.assign(fK, 0);
+    fHasNbr.assign(fK, 0);
+}
+
+void VacancyBatch::ConfigureFromGrid(const VoxelGrid& grid) {
+    fNx = grid.Nx();
+    fNy = grid.Ny();
+    fNz = grid.Nz();
+    fLayout = grid.Layout();
+
+    const size_t n = fLayout.Size();
+    const size_t nChunks = (n + VacancyModel::kInitChunk - 1) / VacancyModel::kInitChunk;
+    fVacChunk.clear();
+    fBankChunk.clear();
+    fVacChunk.resize(nChunks);
+    fBankChunk.resize(nChunks);
+    fAllocated = 0;
+    fBankStamp.Configure(fBankRelax ? n : 0, 0);
+
+    auto seed = grid.GetSeedIndex();
+    fSeedIx = seed.ix;
+    fSeedIy = seed.iy;
+    fSeedIz = seed.iz;
+    fSeedFlat = Flatten(fSeedIx, fSeedIy, fSeedIz);
+
+    for (size_t l = 0; l < fK; ++l) fCap[l] = VacancyModel::CapacityPerVoxel(fParams[l], grid);
+
+    ResetAndInit(grid);
+}
+
+void VacancyBatch::ResetAndInit(const VoxelGrid& grid) {
+    std::fill(fSeedCaptured.begin(), fSeedCaptured.end(), 0);
+    std::fill(fTotalCreated.begin(), fTotalCreated.end(), 0);
+    fBankStamp.Reset();
+    fBankClock = 0;
+
+    // Chunks are drawn lazily on first touch, so a reset costs O(chunks touched)
+    for (size_t l = 0; l < fK; ++l) fLambda[l] = VacancyModel::InitialLambda(fParams[l], grid);
+    for (auto& c : fVacChunk) c.reset();
+    for (auto& c : fBankChunk) c.reset();
+    fAllocated = 0;
+}
+
+void VacancyBatch::AllocateChunk(size_t c) {
+    const size_t chunk = VacancyModel::kInitChunk;
+    const size_t first = c * chunk;
+    const size_t count = std::min(chunk, fLayout.Size() - first);
+
+    fVacChunk[c].reset(new VacancyModel::Count[chunk * fK]());
+    fBankChunk[c].reset(new VacancyModel::Bank[chunk * fK]());
+    ++fAllocated;
+
+    // Same chunk-keyed draws as VacancyModel::ResetAndInit, written lane-strided
+    VacancyModel::Count* block = fVacChunk[c].get();
+    for (size_t l = 0; l < fK; ++l) {
+        if (fLambda[l] > 0.0) {
+            VacancyModel::DrawInitialChunk(fParams[l].initSeed, fLambda[l], fCap[l], c,
+                                           block + l, count, fK);
+            VacancyModel::ClearPadding(fLayout, c, block + l, count, fK);
+        }
+    }
+
+    // at least one seed vacancy in the center voxel
+    if (fSeedFlat / chunk == c) {
+        VacancyModel::Count* seedVac = block + (fSeedFlat - first) * fK;
+        for (size_t l = 0; l < fK; ++l) {
+            if (seedVac[l] == 0) seedVac[l] = 1;
+        }
+    }
+}
+
+size_t VacancyBatch::Flatten(int ix, int iy, int iz) const {
+    return fLayout.Flatten(ix, iy, iz);
+}
+void VacancyBatch::Unflatten(size_t flat, int& ix, int& iy, int& iz) const {
+    fLayout.Unflatten(flat, ix, iy, iz);
+}
+
+void VacancyBatch::ProcessEvent(const EventRecord& ev) {
+    const size_t K = fK;
+    const auto& touched = ev.flat;
+
+    // 1) add event edep to all lanes' energy banks, after decaying the banks
+    // of relaxing lanes to this event
+    double edepSeed_eV = 0.0;
+    if (fBankRelax) ++fBankClock;
+    for (size_t k = 0; k < touched.size(); ++k) {
+        const size_t flat = touched[k];
+        const double edep_eV = ev.edep_eV[k];
+        if (flat == fSeedFlat) edepSeed_eV = edep_eV;
+
+        VacancyModel::Bank* bank = BankLanes(flat);
+        if (fBankRelax && fBankStamp.Get(flat) != fBankClock) {
+            const double dt = (double)(uint32_t)(fBankClock - fBankStamp.Get(flat));
+            const uint64_t key = (uint64_t)flat ^ ((uint64_t)fBankClock << 40);
+            const double* invTau = fBankInvTau.data();
+            for (size_t l = 0; l < K; ++l) {
+                if (invTau[l] > 0.0 && bank[l] != VacancyModel::Bank(0)) {
+                    bank[l] = VoxelStorage::BankDecay(bank[l], std::exp(-dt * invTau[l]), key);
+                }
+            }
+            fBankStamp[flat] = fBankClock;
+        }
+        if (!(edep_eV > 0.0)) continue;
+
+        #pragma omp simd
+        for (size_t l = 0; l < K; ++l) bank[l] = VoxelStorage::BankAdd(bank[l], edep_eV);
+    }
+
+    // 2) update seed captured electrons (W differs per lane)
+    if (edepSeed_eV > 0.0) {
+        for (size_t l = 0; l < K; ++l) {
+            if (fSeedCaptured[l] >= 2 || !(fW[l] > 0.0)) continue;
+            const int dn = (int)std::floor(edepSeed_eV / fW[l]);
+            if (dn > 0) fSeedCaptured[l] = std::min(2, fSeedCaptured[l] + dn);
+        }
+    }
+
+    // 3) create new vacancies, touched voxels in the same order as VacancyModel
+    uint8_t* hasNbr = fHasNbr.data();
+    for (size_t flat : touched) {
+        int ix, iy, iz;
+        Unflatten(flat, ix, iy, iz);
+
+        std::fill(fHasNbr.begin(), fHasNbr.end(), 0);
+        size_t nbFlat[6];
+        const int nNb = fLayout.Neighbors6(flat, nbFlat);
+        for (int q = 0; q < nNb; ++q) {
+            const VacancyModel::Count* nb = VacLanes(nbFlat[q]);
+            #pragma omp simd
+            for (size_t l = 0; l < K; ++l) hasNbr[l] |= (uint8_t)(nb[l] > 0);
+        }
+
+        const int md = std::abs(ix - fSeedIx) + std::abs(iy - fSeedIy) + std::abs(iz - fSeedIz);
+        const uint8_t nearSeed = (md == 1) ? 1 : 0;
+
+        VacancyModel::Count* vac = VacLanes(flat);
+        VacancyModel::Bank* bank = BankLanes(flat);
+        const uint32_t* cap = fCap.data();
+        const double* eaBase = fEaBase.data();
+        const double* eaFast = fEaFast.data();
+        const uint8_t* fastAll = fFastEverywhere.data();
+        const int* captured = fSeedCaptured.data();
+        long long* created = fTotalCreated.data();
+
+        #pragma omp simd
+        for (size_t l = 0; l < K; ++l) {
+            const bool fast = (captured[l] >= 2) && (fastAll[l] || nearSeed);
+            const double Ea = fast ? eaFast[l] : eaBase[l];
+            const bool make = hasNbr[l] && vac[l] < cap[l] && VoxelStorage::BankEV(bank[l]) >= Ea;
+            vac[l] += make ? 1u : 0u;
+            bank[l] = make ? VoxelStorage::BankSub(bank[l], Ea) : bank[l];
+            created[l] += make ? 1 : 0;
+        }
+    }
+}
+
+VacancyBatch::LaneSummary VacancyBatch::Summary(size_t lane) const {
+    LaneSummary s;
+    s.params = fParams.at(lane);
+    s.capPerVoxel = fCap[lane];
+    s.seedCapturedElectrons = fSeedCaptured[lane];
+    s.totalCreated = fTotalCreated[lane];
+    return s;
+}
+
+void VacancyBatch::ExportSummaryCSV(const std::string& path, long long nPrimaries) const {
+    std::ofstream out(path);
+    out << "lane,initConc_cm3,rho_g_cm3,capPerVoxel,W_eV,Ea_base_eV,Ea_fast_eV,"
+        << (fBankRelax ? "bankRelaxEvents," : "")
+        << "seedCapturedElectrons,totalCreated,nPrimaries,createdPerPrimary\n";
+    for (size_t l = 0; l < fK; ++l) {
+        const auto s = Summary(l);
+        out << l << ","
+            << s.params.initConc_cm3 << ","
+            << s.params.rho_g_cm3 << ","
+            << s.capPerVoxel << ","
+            << s.params.W_eV << ","
+            << s.params.Ea_base_eV << ","
+            << s.params.Ea_fast_eV << ",";
+        if (fBankRelax) out << s.params.bankRelaxEvents << ",";
+        out << s.seedCapturedElectrons << ","
+            << s.totalCreated << ","
+            << nPrimaries << ","
+            << (nPrimaries>0 ? (double)s.totalCreated/(double)nPrimaries : 0.0) << "\n";
+    }
+}
@@ -0,0 +1,215 @@
+#include "VacancyKMC.hh"
+#include "VacancyModel.hh"
+#include "EventRecord.hh"
+#include "PotentialSolver.hh"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+static constexpr double kBoltzmann_eV_K = 8.617333262e-5;
+static constexpr size_t kNone = SIZE_MAX;
+
+// The solver publishes its field maxima per storage chunk
+static_assert(ChannelQueue::kBlock == VacancyModel::kInitChunk, "KMC pools must be storage chunks");
+
+void VacancyKMC::Coefficients(const Params& p, double& rg, double& rr, double& rd) {
+    const double kT = kBoltzmann_eV_K * p.T_K;
+    rg = p.attempt_Hz * std::exp(-p.Eg_eV / kT);
+    rr = p.attempt_Hz * std::exp(-p.Er_eV / kT);
+    rd = p.attempt_Hz * std::exp(-p.Ed_eV / kT);
+}
+
+VoxelStorage::Count* VacancyKMC::DenseCounts(const Params& p, VacancyModel& model) {
+    const auto& counts = model.VacCounts();
+    if (!counts.IsDense()) {
+        const double mib = (double)counts.NumChunks() * VacancyModel::kInitChunk
+                         * sizeof(VoxelStorage::Count) / (1024.0 * 1024.0);
+        if (mib > p.maxDense_MiB) {
+            std::ostringstream msg;
+            msg << "VacancyKMC: the dense vacancy field of " << counts.Size() << " voxels needs " << mib
+                << " MiB, above maxDense_MiB = " << p.maxDense_MiB << "; coarsen the grid or raise the limit";
+            throw std::runtime_error(msg.str());
+        }
+    }
+    return model.DenseVacCount();
+}
+
+void VacancyKMC::Attach(VacancyModel& model) {
+    fVac = DenseCounts(fP, model);
+    fModel = &model;
+    fCap = model.CapPerVoxel();
+    fLayout = model.Layout();
+
+    Coefficients(fP, fRg, fRr, fRd);
+    fFieldGain = fP.genDipole_eA * 1e-10 / (kBoltzmann_eV_K * fP.T_K);
+    fFieldOn = fField && fField->HasField() && fP.genDipole_eA > 0.0;
+
+    fRng.seed(fP.seed);
+    fTime = 0.0;
+    fSteps = fGenerated = fRecombined = fHops = 0;
+
+    // Padding entries of the layout (if any) are in no channel
+    const size_t n = fLayout.Size();
+    fQueue.Begin(n, fRg * fCap);
+    for (size_t i = 0; i < n; ++i) {
+        if (!fLayout.IsVoxel(i)) continue;
+        if (fVac[i] == 0) fQueue.AddPooled(i);
+        else fQueue.AddTracked(i, ChannelRate(i));
+    }
+    fQueue.Build(fRng);
+    if (fFieldOn) SetEmptyRates();
+}
+
+void VacancyKMC::SetField(const PotentialSolver* field) {
+    fField = field;
+    FieldChanged();
+}
+
+void VacancyKMC::FieldChanged() {
+    fFieldOn = fField && fField->HasField() && fP.genDipole_eA > 0.0;
+    if (!fModel) return;
+    SetEmptyRates();
+    fQueue.ForEachTracked([this](size_t flat) { fQueue.Track(flat, ChannelRate(flat), fTime, fRng); });
+}
+
+void VacancyKMC::SetEmptyRates() {
+    // Pools fire at the largest rate in their block and thin (FirePool)
+    for (size_t b = 0; b < fQueue.Blocks(); ++b) {
+        const double rg = fFieldOn ? fRg * std::exp(fFieldGain * fField->FieldChunkMax(b)) : fRg;
+        fQueue.SetEmptyRate(b, rg * fCap, fTime, fRng);
+    }
+}
+
+double VacancyKMC::GenRate(size_t flat) const {
+    return fFieldOn ? fRg * std::exp(fFieldGain * fField->Field(flat)) : fRg;
+}
+
+double VacancyKMC::ChannelRate(size_t flat) const {
+    const uint32_t n = fVac[flat];
+    const uint32_t free = (n < fCap) ? fCap - n : 0;
+    double rate = GenRate(flat) * free + fRr * n;
+    if (n > 0) {
+        size_t nb[6];
+        const int k = fLayout.Neighbors6(flat, nb);
+        int open = 0;
+        for (int j = 0; j < k; ++j) open += (fVac[nb[j]] < fCap);
+        rate += fRd * n * open;
+    }
+    return rate;
+}
+
+void VacancyKMC::Reschedule(size_t flat) {
+    if (fVac[flat] == 0) fQueue.Pool(flat, fTime, fRng);
+    else fQueue.Track(flat, ChannelRate(flat), fTime, fRng);
+}
+
+void VacancyKMC::RescheduleAround(size_t flat) {
+    Reschedule(flat);
+    size_t nb[6];
+    const int k = fLayout.Neighbors6(flat, nb);
+    for (int j = 0; j < k; ++j) Reschedule(nb[j]);
+}
+
+size_t VacancyKMC::FirePool(size_t block) {
+    const size_t flat = fQueue.Pick(block, [this](size_t i) {
+        return fLayout.IsVoxel(i) && fVac[i] == 0;
+    }, fRng);
+    if (fFieldOn && ChannelQueue::Uniform(fRng) * fQueue.EmptyRate(block) >= GenRate(flat) * fCap) {
+        return kNone;   // thinned: the voxel's own rate is below the block bound
+    }
+    fVac[flat] = 1;
+    fModel->NoteOccupied(flat);
+    ++fGenerated;
+    return flat;
+}
+
+void VacancyKMC::Fire(size_t ch) {
+    fTime = fQueue.Key(ch);
+
+    if (fQueue.IsPool(ch)) {
+        fQueue.Redraw(ch, fQueue.PoolRate(ch), fTime, fRng);
+        const size_t flat = FirePool(ch);
+        if (flat != kNone) {
+            ++fSteps;
+            RescheduleAround(flat);
+        }
+        return;
+    }
+    ++fSteps;
+
+    const size_t flat = fQueue.Voxel(ch);
+    const uint32_t n = fVac[flat];
+    const uint32_t free = (n < fCap) ? fCap - n : 0;
+    double u = ChannelQueue::Uniform(fRng) * fQueue.Rate(ch);
+
+    size_t target = flat;   // voxel receiving a hop, if any
+    const double gen = GenRate(flat) * free;
+    const double rec = fRr * n;
+    if (u < gen) {
+        fVac[flat] = n + 1;
+        ++fGenerated;
+    } else if ((u -= gen) < rec) {
+        fVac[flat] = n - 1;
+        if (n == 1) fModel->NoteEmptied(flat);
+        ++fRecombined;
+    } else {
+        u -= rec;
+        size_t nb[6];
+        const int k = fLayout.Neighbors6(flat, nb);
+        const double hop = fRd * n;
+        for (int j = 0; j < k; ++j) {
+            if (fVac[nb[j]] >= fCap) continue;
+            target = nb[j];
+            if (u < hop) break;
+            u -= hop;
+        }
+        if (target != flat) {
+            fVac[flat] = n - 1;
+            if (n == 1) fModel->NoteEmptied(flat);
+            if (fVac[target]++ == 0) fModel->NoteOccupied(target);
+            ++fHops;
+        } else if (rec > 0.0) {
+            // rounding pushed u past every hop and no neighbour is open
+            fVac[flat] = n - 1;
+            if (n == 1) fModel->NoteEmptied(flat);
+            ++fRecombined;
+        }
+    }
+
+    // The fired channel draws a fresh time (or is pooled if its voxel
+    // emptied); everything else it touched is rescaled
+    if (fVac[flat] > 0) fQueue.Redraw(ch, ChannelRate(flat), fTime, fRng);
+    RescheduleAround(flat);
+    if (target != flat) RescheduleAround(target);
+}
+
+long long VacancyKMC::Advance(double dt_s, long long maxSteps) {
+    if (!fModel || fQueue.Empty()) return 0;
+
+    const double tEnd = fTime + dt_s;
+    long long steps = 0;
+    while (maxSteps < 0 || steps < maxSteps) {
+        if (fQueue.TopKey() > tEnd) {
+            fTime = tEnd;   // memoryless: pending times stay valid
+            break;
+        }
+        Fire(fQueue.Top());
+        ++steps;
+    }
+    return steps;
+}
+
+void VacancyKMC::OnEvent(const EventRecord& ev) {
+    if (!fModel) return;
+    for (size_t flat : ev.flat) RescheduleAround(flat);
+}
+
+void VacancyKMC::WriteSummaryRows(std::ostream& out) const {
+    out << "kmc_T_K," << fP.T_K << "\n";
+    out << "kmc_time_s," << fTime << "\n";
+    out << "kmc_steps," << fSteps << "\n";
+    out << "kmc_generated," << fGenerated << "\n";
+    out << "kmc_recombined," << fRecombined << "\n";
+    out << "kmc_hops," << fHops << "\n";
+}
@@ -1,20 +1,33 @@
 #include "VacancyModel.hh"
 #include "VoxelGrid.hh"
-#include "G4SystemOfUnits.hh" // for cm
+#include "EventRecord.hh"
+#include "NpyWriter.hh"
+#include "Philox.hh"
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+using hfo2units::cm;
 
 static constexpr double kNA = 6.02214076e23; // Avogadro (mol^-1)
 
-double VacancyModel::OxygenSiteDensity_cm3() const {
+double VacancyModel::OxygenSiteDensity_cm3(const Params& p) {
     // n_O = 2 * (rho/M) * NA
-    const double n_formula = (fP.rho_g_cm3 / fP.molarMass_g_mol) * kNA;
+    const double n_formula = (p.rho_g_cm3 / p.molarMass_g_mol) * kNA;
     return 2.0 * n_formula;
 }
 
-uint32_t VacancyModel::CapacityPerVoxel(const VoxelGrid& grid) const {
-    const double nO = OxygenSiteDensity_cm3(); // cm^-3
+uint32_t VacancyModel::CapacityPerVoxel(const Params& p, const VoxelGrid& grid) {
+    const double nO = OxygenSiteDensity_cm3(p); // cm^-3
     const double Vvox_cm3 =
             (grid.Dx() / cm) * (grid.Dy() / cm) * (grid.Dz() / cm);
     const double cap = std::floor(nO * Vvox_cm3);
+    if (cap > (double)std::numeric_limits<Count>::max()) {
+        throw std::runtime_error("VacancyModel: " + std::to_string((long long)cap) +
+                                 " oxygen sites per voxel do not fit the " + VoxelStorage::kName +
+                                 " vacancy counts (use smaller voxels or a wider HFO2_STORAGE)");
+    }
     return (cap < 1.0) ? 1u : (uint32_t)cap;
 }
 
@@ -22,145 +35,379 @@ void VacancyModel::ConfigureFromGrid(const VoxelGrid& grid) {
     fNx = grid.Nx();
     fNy = grid.Ny();
     fNz = grid.Nz();
+    fLayout = grid.Layout();
 
-    const size_t n = (size_t)fNx * (size_t)fNy * (size_t)fNz;
-    fVacCount.assign(n, 0);
-    fEbank_eV.assign(n, 0.0f);
+    const size_t n = fLayout.Size();
+    fVacCount.Configure(n, 0);
+    fEbank_eV.Configure(n, 0.0f);
+    fBankStamp.Configure(n, 0);
 
     auto seed = grid.GetSeedIndex();
     fSeedIx = seed.ix;
     fSeedIy = seed.iy;
     fSeedIz = seed.iz;
     fSeedFlat = Flatten(fSeedIx, fSeedIy, fSeedIz);
+    fSeedNbrCount = fLayout.Neighbors6(fSeedFlat, fSeedNbr);
+    fNbr.Configure(n, kNbrUnknown);
 
-    fCapPerVoxel = CapacityPerVoxel(grid);
+    fCapPerVoxel = CapacityPerVoxel(fP, grid);
+
+    fPerc = PercolationTracker();   // reconfigured for the new shape on demand
 
     ResetAndInit(grid);
 }
 
-void VacancyModel::ResetAndInit(const VoxelGrid& grid) {
-    std::fill(fVacCount.begin(), fVacCount.end(), 0);
-    std::fill(fEbank_eV.begin(), fEbank_eV.end(), 0.0f);
-
-    fSeedCapturedElectrons = 0;
-    fTotalCreated = 0;
-
-    // Init RNG
-    fRng.seed(fP.initSeed);
-
+double VacancyModel::InitialLambda(const Params& p, const VoxelGrid& grid) {
     // Clamp concentration by physical maximum nO
-    const double nO = OxygenSiteDensity_cm3();
-    double C0 = std::max(0.0, fP.initConc_cm3);
+    const double nO = OxygenSiteDensity_cm3(p);
+    double C0 = std::max(0.0, p.initConc_cm3);
     if (C0 > nO) C0 = nO;
 
-    // Fill vacancies per voxel using Poisson(C0 * Vvox), then cap by capacity
+    // Mean vacancies per voxel: C0 * Vvox
     const double Vvox_cm3 =
             (grid.Dx() / cm) * (grid.Dy() / cm) * (grid.Dz() / cm);
-    const double lambda = C0 * Vvox_cm3;
-
-    // For speed/stability: Poisson is fine for your sizes; if needed, add a normal approx for huge lambda.
-    std::poisson_distribution<int> pois(lambda);
-
-    for (size_t i = 0; i < fVacCount.size(); ++i) {
-        uint32_t v = 0;
-        if (lambda > 0.0) {
-            int draw = pois(fRng);
-            if (draw < 0) draw = 0;
-            v = (uint32_t)draw;
-            if (v > fCapPerVoxel) v = fCapPerVoxel;
+    return C0 * Vvox_cm3;
+}
+
+void VacancyModel::DrawInitialChunk(uint64_t seed, double lambda, uint32_t cap,
+                                    size_t chunk, Count* out, size_t count, size_t stride) {
+    if (!(lambda > 0.0)) {
+        for (size_t i = 0; i < count; ++i) out[i * stride] = 0;
+        return;
+    }
+
+    // Philox stream (seed, chunk): independent and order-free per chunk
+    PhiloxStream rng(seed, chunk);
+    const double p0 = std::exp(-lambda);   // P(no vacancy)
+
+    if (lambda < kSparseLambda) {
+        // Mostly empty: geometric gaps to the next occupied voxel, whose
+        // count is drawn from the Poisson distribution conditioned on > 0
+        for (size_t i = 0; i < count; ++i) out[i * stride] = 0;
+        size_t i = 0;
+        while (true) {
+            const double gap = std::floor(std::log(rng.Uniform()) / -lambda);
+            if (gap >= (double)(count - i)) break;
+            i += (size_t)gap;
+            const double u = p0 + (1.0 - p0) * (1.0 - rng.Uniform());
+            uint32_t k = 1;
+            double p = p0 * lambda, cdf = p0 + p;
+            while (u > cdf && k < cap) {
+                ++k;
+                p *= lambda / k;
+                cdf += p;
+            }
+            out[i * stride] = (Count)std::min(k, cap);
+            ++i;
+        }
+    } else if (lambda <= kNormalLambda) {
+        // Inversion by bisection in the tabulated distribution, out to 12
+        // standard deviations (or the capacity)
+        const uint32_t kMax = std::min<uint32_t>(cap, (uint32_t)(lambda + 12.0 * std::sqrt(lambda) + 10.0));
+        std::vector<double> cdf(kMax + 1);
+        double sum = 0.0;
+        for (uint32_t k = 0; k <= kMax; ++k) {
+            sum += std::exp(k * std::log(lambda) - lambda - std::lgamma(k + 1.0));
+            cdf[k] = sum;
+        }
+        cdf[kMax] = 1.0;   // the capacity takes the tail
+        for (size_t i = 0; i < count; ++i) {
+            const double u = 1.0 - rng.Uniform();
+            out[i * stride] = (Count)(std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+        }
+    } else {
+        // Normal approximation N(lambda, lambda), rounded (Box-Muller pairs)
+        const double sd = std::sqrt(lambda);
+        for (size_t i = 0; i < count; i += 2) {
+            const double r = std::sqrt(-2.0 * std::log(rng.Uniform()));
+            const double phi = 6.283185307179586 * rng.Uniform();
+            const double z[2] = {r * std::cos(phi), r * std::sin(phi)};
+            for (size_t j = 0; j < 2 && i + j < count; ++j) {
+                const double v = std::floor(lambda + sd * z[j] + 0.5);
+                out[(i + j) * stride] = (Count)(v <= 0.0 ? 0u : v >= (double)cap ? cap : (uint32_t)v);
+            }
         }
-        fVacCount[i] = v;
     }
+}
+
+void VacancyModel::ResetAndInit(const VoxelGrid& grid) {
+    fSeedCapturedElectrons = 0;
+    fTotalCreated = 0;
+
+    // Fill vacancies per voxel using Poisson(C0 * Vvox), then cap by capacity.
+    // Chunks are drawn lazily on first access, so a reset costs O(chunks touched).
+    const double lambda = InitialLambda(fP, grid);
+    if (lambda > 0.0) {
+        const uint64_t seed = fP.initSeed;
+        const uint32_t cap = fCapPerVoxel;
+        const VoxelLayout layout = fLayout;
+        fVacCount.SetInitializer([seed, lambda, cap, layout](size_t chunk, Count* data, size_t count) {
+            DrawInitialChunk(seed, lambda, cap, chunk, data, count);
+            ClearPadding(layout, chunk, data, count);
+        });
+    } else {
+        fVacCount.SetInitializer(nullptr);
+    }
+    fEbank_eV.Reset();
+    fBankRelax = fP.bankRelaxEvents > 0.0;
+    fBankInvTau = fBankRelax ? 1.0 / fP.bankRelaxEvents : 0.0;
+    fBankClock = 0;
+    fBankStamp.Reset();
 
     // Ensure at least one seed vacancy in the center voxel
     if (fVacCount[fSeedFlat] == 0) fVacCount[fSeedFlat] = 1;
+    fNbr.Reset();
+
+    fPercolated = false;
+    fPercolationEvent = -1;
+    if (fP.trackPercolation) {
+        if (!fPerc.IsConfigured()) fPerc.Configure(fLayout, fNz);
+        fPerc.Rebuild(fVacCount);
+        fPercolated = fPerc.Spanning();
+        fPercStale = fPercUnknown = false;
+    } else {
+        fPerc = PercolationTracker();
+    }
 }
 
-// --- helpers (same as before, but now "vacancy exists" means vacCount>0)
+bool VacancyModel::RebuildPercolation() {
+    if (!fPerc.IsConfigured()) return false;
+    fPerc.Rebuild(fVacCount);
+    fPercStale = fPercUnknown = false;
+    return fPerc.Spanning();
+}
 
-bool VacancyModel::IsInBounds(int ix, int iy, int iz) const {
-    return (ix >= 0 && ix < fNx && iy >= 0 && iy < fNy && iz >= 0 && iz < fNz);
+void VacancyModel::UpdatePercolation(long long eventId) {
+    if (fPercolated || !fPerc.IsConfigured()) return;
+    // A stale tracker only over-connects, so "not spanning" can be trusted
+    if (fPercUnknown || (fPercStale && fPerc.Spanning())) RebuildPercolation();
+    if (fPerc.Spanning()) {
+        fPercolated = true;
+        fPercolationEvent = eventId;
+    }
 }
+
+// --- helpers (same as before, but now "vacancy exists" means vacCount>0)
+
 size_t VacancyModel::Flatten(int ix, int iy, int iz) const {
-    return (size_t)iz + (size_t)fNz * ((size_t)iy + (size_t)fNy * (size_t)ix);
+    return fLayout.Flatten(ix, iy, iz);
 }
 void VacancyModel::Unflatten(size_t flat, int& ix, int& iy, int& iz) const {
-    const size_t yz = (size_t)fNy * (size_t)fNz;
-    ix = (int)(flat / yz);
-    const size_t rem = flat - (size_t)ix * yz;
-    iy = (int)(rem / (size_t)fNz);
-    iz = (int)(rem - (size_t)iy * (size_t)fNz);
+    fLayout.Unflatten(flat, ix, iy, iz);
 }
 
-bool VacancyModel::HasVacancyNeighbor6(int ix, int iy, int iz) const {
-    const int dx[6] = {+1,-1, 0, 0, 0, 0};
-    const int dy[6] = { 0, 0,+1,-1, 0, 0};
-    const int dz[6] = { 0, 0, 0, 0,+1,-1};
-    for (int k=0;k<6;++k) {
-        int nx = ix + dx[k], ny = iy + dy[k], nz = iz + dz[k];
-        if (!IsInBounds(nx,ny,nz)) continue;
-        if (fVacCount[Flatten(nx,ny,nz)] > 0) return true;
+void VacancyModel::ClearPadding(const VoxelLayout& layout, size_t chunk, Count* data, size_t count,
+                                size_t stride) {
+    if (VoxelLayout::kRowMajor) return;
+    const size_t first = chunk * kInitChunk;
+    for (size_t i = 0; i < count; ++i) {
+        if (!layout.IsVoxel(first + i)) data[i * stride] = 0;
+    }
+}
+
+uint8_t& VacancyModel::NeighborByte(size_t flat) {
+    uint8_t& x = fNbr.Ref(flat);
+    if (x == kNbrUnknown) {
+        size_t nb[6];
+        const int k = fLayout.Neighbors6(flat, nb);
+        uint8_t n = 0;
+        for (int j = 0; j < k; ++j) n += (fVacCount[nb[j]] > 0);
+        for (int j = 0; j < fSeedNbrCount; ++j) {
+            if (fSeedNbr[j] == flat) n |= kSeedNbrBit;
+        }
+        x = n;
     }
-    return false;
+    return x;
 }
 
-bool VacancyModel::IsNeighborOfSeed6(int ix, int iy, int iz) const {
-    const int md = std::abs(ix - fSeedIx) + std::abs(iy - fSeedIy) + std::abs(iz - fSeedIz);
-    return (md == 1);
+void VacancyModel::AdjustNeighbors(size_t flat, int delta) {
+    size_t nb[6];
+    const int k = fLayout.Neighbors6(flat, nb);
+    for (int j = 0; j < k; ++j) {
+        if (!fNbr.IsAllocated(nb[j] / kNbrChunk)) continue;
+        uint8_t& x = fNbr.Ref(nb[j]);
+        if (x != kNbrUnknown) x = (uint8_t)(x + delta);
+    }
 }
 
-void VacancyModel::ProcessEvent(const VoxelGrid& grid) {
-    // 1) add event edep to energy bank
-    const auto& touched = grid.GetTouchedVoxels();
-    for (size_t flat : touched) {
-        const double edep_eV = grid.GetEdepEvent_eV(flat);
-        if (edep_eV > 0.0) fEbank_eV[flat] += (float)edep_eV;
+void VacancyModel::ProcessEvent(const EventRecord& ev) {
+    // 1) add event edep to energy bank, after decaying it to this event
+    const auto& touched = ev.flat;
+    double edepSeed_eV = 0.0;
+    if (fBankRelax) ++fBankClock;
+    for (size_t k = 0; k < touched.size(); ++k) {
+        const size_t flat = touched[k];
+        const double edep_eV = ev.edep_eV[k];
+        if (fBankRelax) {
+            uint32_t& stamp = fBankStamp[flat];
+            if (stamp != fBankClock) {
+                Bank& b = fEbank_eV[flat];
+                if (b != Bank(0)) {
+                    const uint64_t key = (uint64_t)flat ^ ((uint64_t)fBankClock << 40);
+                    b = VoxelStorage::BankDecay(b, BankDecayFactor(fBankClock - stamp), key);
+                }
+                stamp = fBankClock;
+            }
+        }
+        if (edep_eV > 0.0) fEbank_eV[flat] = VoxelStorage::BankAdd(fEbank_eV[flat], edep_eV);
+        if (flat == fSeedFlat) edepSeed_eV = edep_eV;
     }
 
     // 2) update seed captured electrons
     if (fSeedCapturedElectrons < 2) {
-        const double edepSeed_eV = grid.GetEdepEvent_eV(fSeedFlat);
         if (edepSeed_eV > 0.0 && fP.W_eV > 0.0) {
             const int dn = (int)std::floor(edepSeed_eV / fP.W_eV);
             if (dn > 0) fSeedCapturedElectrons = std::min(2, fSeedCapturedElectrons + dn);
         }
     }
 
-    // 3) create new vacancies in touched voxels adjacent to existing vacancies
-    for (size_t flat : touched) {
-        // if voxel already "full" of vacancies, skip
-        if (fVacCount[flat] >= fCapPerVoxel) continue;
+    // 3) eligibility of every touched voxel (below capacity, bank >= Ea) in
+    // one pass over its gathered state
+    const size_t n = touched.size();
+    fTouchVacRef.resize(n);
+    fTouchBankRef.resize(n);
+    fTouchNbrRef.resize(n);
+    fTouchVac.resize(n);
+    fTouchBank_eV.resize(n);
+    fTouchNbr.resize(n);
+    fTouchCand.resize(n);
+    for (size_t k = 0; k < n; ++k) {
+        const size_t flat = touched[k];
+        fTouchVacRef[k] = &fVacCount[flat];
+        fTouchBankRef[k] = &fEbank_eV[flat];
+        fTouchNbrRef[k] = &NeighborByte(flat);
+        fTouchVac[k] = *fTouchVacRef[k];
+        fTouchBank_eV[k] = VoxelStorage::BankEV(*fTouchBankRef[k]);
+        fTouchNbr[k] = *fTouchNbrRef[k];
+    }
+    const bool fast = fSeedCapturedElectrons >= 2;
+    const bool fastAll = fast && !fP.fastOnlyNearSeed;
+    const double eaBase = fP.Ea_base_eV, eaFast = fP.Ea_fast_eV;
+    const uint32_t cap = fCapPerVoxel;
+    const uint32_t* vac = fTouchVac.data();
+    const double* bank = fTouchBank_eV.data();
+    const uint8_t* nbr = fTouchNbr.data();
+    uint8_t* cand = fTouchCand.data();
+    #pragma omp simd
+    for (size_t k = 0; k < n; ++k) {
+        const bool useFast = fastAll || (fast && (nbr[k] & kSeedNbrBit));
+        const double Ea = useFast ? eaFast : eaBase;
+        cand[k] = (uint8_t)(vac[k] < cap && bank[k] >= Ea);
+    }
 
-        int ix, iy, iz;
-        Unflatten(flat, ix, iy, iz);
+    // 4) create new vacancies in touched order next to existing ones. The
+    // neighbour test runs on the current field, since an earlier voxel of
+    // this event may just have become occupied; counts only grow and banks
+    // only shrink here, so a voxel that failed step 3 cannot qualify. (Chunks
+    // do not move, so the slots gathered in step 3 stay valid.)
+    for (size_t k = 0; k < n; ++k) {
+        if (!cand[k]) continue;
+        const uint8_t nb = *fTouchNbrRef[k];
+        if (!(nb & kNbrCountMask)) continue;
 
-        if (!HasVacancyNeighbor6(ix,iy,iz)) continue;
+        // current values: a voxel listed twice was changed by its first entry
+        const size_t flat = touched[k];
+        Count& v = *fTouchVacRef[k];
+        Bank& b = *fTouchBankRef[k];
+        const double Ea = (fastAll || (fast && (nb & kSeedNbrBit))) ? eaFast : eaBase;
+        if (v >= cap || VoxelStorage::BankEV(b) < Ea) continue;
 
-        double Ea = fP.Ea_base_eV;
-        if (fSeedCapturedElectrons >= 2) {
-            if (!fP.fastOnlyNearSeed) Ea = fP.Ea_fast_eV;
-            else if (IsNeighborOfSeed6(ix,iy,iz)) Ea = fP.Ea_fast_eV;
+        // Create ONE vacancy (you can allow multiple by while-loop if you want)
+        if (v++ == 0) {
+            AdjustNeighbors(flat, +1);
+            if (fPerc.IsConfigured()) fPerc.Occupy(flat);
         }
+        b = VoxelStorage::BankSub(b, Ea);
+        fTotalCreated += 1;
+    }
 
-        if ((double)fEbank_eV[flat] >= Ea) {
-            // Create ONE vacancy (you can allow multiple by while-loop if you want)
-            fVacCount[flat] += 1;
-            fEbank_eV[flat] = (float)((double)fEbank_eV[flat] - Ea);
-            fTotalCreated += 1;
-        }
+    // 5) filament check: only newly occupied voxels can complete a path
+    UpdatePercolation(ev.eventId);
+}
+
+template <class T>
+static void WritePod(std::ostream& out, const T& v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <class T>
+static void ReadPod(std::istream& in, T& v) {
+    if (!in.read(reinterpret_cast<char*>(&v), sizeof(T))) {
+        throw std::runtime_error("VacancyModel: truncated state");
+    }
+}
+
+void VacancyModel::SaveState(std::ostream& out) const {
+    WritePod(out, fCapPerVoxel);
+    WritePod(out, fP.initConc_cm3);
+    WritePod(out, fP.initSeed);
+    WritePod(out, (int32_t)fSeedCapturedElectrons);
+    WritePod(out, (int64_t)fTotalCreated);
+    WritePod(out, (uint8_t)fPercolated);
+    WritePod(out, (int64_t)fPercolationEvent);
+    fVacCount.Save(out);
+    fEbank_eV.Save(out);
+    WritePod(out, fBankClock);
+    fBankStamp.Save(out);
+}
+
+void VacancyModel::LoadState(std::istream& in, bool withBankClock) {
+    uint32_t cap = 0;
+    double conc = 0.0;
+    uint64_t seed = 0;
+    ReadPod(in, cap);
+    ReadPod(in, conc);
+    ReadPod(in, seed);
+    if (cap != fCapPerVoxel || conc != fP.initConc_cm3 || seed != fP.initSeed) {
+        throw std::runtime_error("VacancyModel: checkpoint was written with a different "
+                                 "voxel capacity or initial vacancy field");
+    }
+
+    int32_t captured = 0;
+    int64_t created = 0, percEvent = -1;
+    uint8_t percolated = 0;
+    ReadPod(in, captured);
+    ReadPod(in, created);
+    ReadPod(in, percolated);
+    ReadPod(in, percEvent);
+    fVacCount.Load(in);
+    fEbank_eV.Load(in);
+    if (withBankClock) {
+        ReadPod(in, fBankClock);
+        fBankStamp.Load(in);
     }
+
+    fSeedCapturedElectrons = captured;
+    fTotalCreated = created;
+    fNbr.Reset();
+    if (fPerc.IsConfigured()) RebuildPercolation();
+    fPercolated = percolated != 0;
+    fPercolationEvent = percEvent;
 }
 
 void VacancyModel::ExportVacancyCSV(const std::string& path, const VoxelGrid& grid) const {
+    // Logical-order copies off the row-major layout: per-voxel Get() would
+    // redraw lazily initialized chunks over and over
+    std::vector<Count> vac;
+    std::vector<Bank> bank;
+    std::vector<uint32_t> stamp;
+    if (!VoxelLayout::kRowMajor) {
+        vac = LogicalOrder(fLayout, fVacCount, fNx, fNy, fNz);
+        bank = LogicalOrder(fLayout, fEbank_eV, fNx, fNy, fNz);
+        if (fBankRelax) stamp = LogicalOrder(fLayout, fBankStamp, fNx, fNy, fNz);
+    }
+
     std::ofstream out(path);
     out << "ix,iy,iz,vacCount,Ebank_eV,edepRun_eV,seed\n";
+    size_t logical = 0;
     for (int ix=0; ix<fNx; ++ix) {
         for (int iy=0; iy<fNy; ++iy) {
-            for (int iz=0; iz<fNz; ++iz) {
+            for (int iz=0; iz<fNz; ++iz, ++logical) {
                 const size_t flat = Flatten(ix,iy,iz);
                 out << ix << "," << iy << "," << iz << ","
-                        << fVacCount[flat] << ","
-                        << (double)fEbank_eV[flat] << ","
+                        << (vac.empty() ? fVacCount.Get(flat) : vac[logical]) << ","
+                        << (bank.empty() ? BankNow_eV(fEbank_eV.Get(flat), fBankStamp.Get(flat))
+                                         : BankNow_eV(bank[logical], stamp.empty() ? 0 : stamp[logical])) << ","
                         << grid.GetEdepRun_eV(flat) << ","
                         << ((flat==fSeedFlat)?1:0) << "\n";
             }
@@ -168,6 +415,94 @@ void VacancyModel::ExportVacancyCSV(const std::string& path, const VoxelGrid& gr
     }
 }
 
+// Storage values in the export dtypes (uint32 counts, float32 banks in eV)
+static void WriteCounts(NpyWriter& out, const VacancyModel::Count* data, size_t count) {
+    out.WriteAs<uint32_t>(data, count, [](VacancyModel::Count n) { return (uint32_t)n; });
+}
+
+static void WriteBanks(NpyWriter& out, const VacancyModel::Bank* data, size_t count) {
+    out.WriteAs<float>(data, count, [](VacancyModel::Bank b) { return (float)VoxelStorage::BankEV(b); });
+}
+
+void VacancyModel::ExportVacancyNpy(const std::string& prefix) const {
+    const std::vector<size_t> shape = {(size_t)fNx, (size_t)fNy, (size_t)fNz};
+
+    NpyWriter vacOut;
+    if (vacOut.Open(prefix + "_vacCount.npy", NpyWriter::Descr<uint32_t>(), shape)) {
+        if (VoxelLayout::kRowMajor) {
+            fVacCount.ForEachChunk([&](size_t, const Count* data, size_t count) {
+                WriteCounts(vacOut, data, count);
+            });
+        } else {
+            const auto vac = LogicalOrder(fLayout, fVacCount, fNx, fNy, fNz);
+            WriteCounts(vacOut, vac.data(), vac.size());
+        }
+    }
+
+    // Banks decayed to the last event when relaxing (stampOf(i): stamp of data[i])
+    NpyWriter bankOut;
+    auto writeBanks = [&](const Bank* data, size_t count, auto&& stampOf) {
+        if (!fBankRelax) return WriteBanks(bankOut, data, count);
+        std::vector<float> buf(count);
+        for (size_t i = 0; i < count; ++i) buf[i] = (float)BankNow_eV(data[i], stampOf(i));
+        bankOut.Write(buf.data(), count);
+    };
+    if (bankOut.Open(prefix + "_Ebank_eV.npy", NpyWriter::Descr<float>(), shape)) {
+        if (VoxelLayout::kRowMajor) {
+            fEbank_eV.ForEachChunk([&](size_t chunk, const Bank* data, size_t count) {
+                const size_t first = chunk * kInitChunk;
+                writeBanks(data, count, [&](size_t i) { return fBankStamp.Get(first + i); });
+            });
+        } else {
+            const auto bank = LogicalOrder(fLayout, fEbank_eV, fNx, fNy, fNz);
+            std::vector<uint32_t> stamp;
+            if (fBankRelax) stamp = LogicalOrder(fLayout, fBankStamp, fNx, fNy, fNz);
+            writeBanks(bank.data(), bank.size(), [&](size_t i) { return stamp[i]; });
+        }
+    }
+}
+
+void VacancyModel::ExportVacancyNpySparse(const std::string& prefix) const {
+    NpyWriter idxOut, vacOut, bankOut;
+    if (!idxOut.Open(prefix + "_sparse_idx.npy", NpyWriter::Descr<int32_t>(), {0, 3}) ||
+        !vacOut.Open(prefix + "_sparse_vacCount.npy", NpyWriter::Descr<uint32_t>(), {0}) ||
+        !bankOut.Open(prefix + "_sparse_Ebank_eV.npy", NpyWriter::Descr<float>(), {0})) return;
+
+    // Storage order is logical order only under the row-major layout; other
+    // layouts collect the entries and sort them first
+    struct Entry { size_t key; int32_t ijk[3]; uint32_t vac; float bank; };
+    std::vector<Entry> entries;
+    RowMajorLayout rm;
+    rm.Configure(fNx, fNy, fNz);
+    size_t nnz = 0;
+    auto emit = [&](const Entry& e) {
+        idxOut.Write(e.ijk, 3);
+        vacOut.Write(&e.vac, 1);
+        bankOut.Write(&e.bank, 1);
+        ++nnz;
+    };
+    fVacCount.ForEachChunk([&](size_t chunk, const Count* vac, size_t count) {
+        const size_t first = chunk * kInitChunk;
+        const bool bankAllocated = fEbank_eV.IsAllocated(chunk);
+        for (size_t i = 0; i < count; ++i) {
+            const float bank = bankAllocated ? (float)BankNow_eV(fEbank_eV.Get(first + i),
+                                                                 fBankStamp.Get(first + i)) : 0.0f;
+            if (vac[i] == 0 && bank == 0.0f) continue;
+
+            int ix, iy, iz;
+            Unflatten(first + i, ix, iy, iz);
+            const Entry e{rm.Flatten(ix, iy, iz), {ix, iy, iz}, vac[i], bank};
+            if (VoxelLayout::kRowMajor) emit(e);
+            else entries.push_back(e);
+        }
+    });
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+    for (const auto& e : entries) emit(e);
+    idxOut.SetLeadingDim(nnz);
+    vacOut.SetLeadingDim(nnz);
+    bankOut.SetLeadingDim(nnz);
+}
+
 void VacancyModel::ExportSummaryCSV(const std::string& path, long long nPrimaries) const {
     std::ofstream out(path);
     out << "key,value\n";
@@ -177,8 +512,13 @@ void VacancyModel::ExportSummaryCSV(const std::string& path, long long nPrimarie
     out << "W_eV," << fP.W_eV << "\n";
     out << "Ea_base_eV," << fP.Ea_base_eV << "\n";
     out << "Ea_fast_eV," << fP.Ea_fast_eV << "\n";
+    if (fBankRelax) out << "bankRelaxEvents," << fP.bankRelaxEvents << "\n";
     out << "seedCapturedElectrons," << fSeedCapturedElectrons << "\n";
     out << "totalCreated," << fTotalCreated << "\n";
     out << "nPrimaries," << nPrimaries << "\n";
     out << "createdPerPrimary," << (nPrimaries>0 ? (double)fTotalCreated/(double)nPrimaries : 0.0) << "\n";
+    if (fP.trackPercolation) {
+        out << "percolated," << (fPercolated ? 1 : 0) << "\n";
+        out << "percolationEvent," << fPercolationEvent << "\n";
+    }
 }
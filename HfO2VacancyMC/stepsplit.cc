@@ -0,0 +1,260 @@
+// Binning error against steps per primary for the two HfO2 scoring modes:
+// the whole step deposit at the step midpoint (VoxelGrid::AddEdep, default)
+// and the deposit split by path length over the crossed voxels
+// (VoxelGrid::AddSegment, /det/splitSteps true).
+//
+// Synthetic electron tracks (no Geant4): a fine polyline with continuous
+// angular diffusion and occasional hard deflections, depositing a constant
+// dE/dx. The reference is the fine polyline split exactly over the voxels.
+// Each step limit L then cuts the same tracks into Geant4-like steps: a step
+// ends at a hard deflection or after L of path, its end points lie on the
+// true path and it carries dE/dx times its true length. The split mode only
+// loses the curvature inside a step; the midpoint mode also puts the whole
+// step into one voxel.
+//
+// Usage: HfO2StepSplitBench [key=value ...]
+//   limits=0.1,0.2,0.5,1,2,5,0   step limits in nm (0: hard deflections only)
+//   nxy=64, nz=10, dxyNm=5, dzNm=1   grid
+//   primaries=1000, rangeNm=30, dEdx_eVnm=20
+//   fineNm=0.02                 reference path resolution
+//   diffusion=0.3               angular diffusion (rad / sqrt(nm))
+//   mfpNm=3                     mean free path between hard deflections
+//   seed=1
+//
+// Reported per limit and mode: steps per primary, L1 error over voxels and
+// over the depth profile (sum |E - Eref| / sum Eref) and ns per primary for
+// scoring plus the end-of-event record fill.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "VoxelGrid.hh"
+#include "EventRecord.hh"
+
+using hfo2units::nm;
+using hfo2units::eV;
+
+namespace {
+
+struct Options {
+    std::vector<double> limits{0.1, 0.2, 0.5, 1.0, 2.0, 5.0, 0.0};
+    int nxy = 64, nz = 10;
+    double dxyNm = 5.0, dzNm = 1.0;
+    int primaries = 1000;
+    double rangeNm = 30.0, dEdx_eVnm = 20.0;
+    double fineNm = 0.02, diffusion = 0.3, mfpNm = 3.0;
+    uint64_t seed = 1;
+};
+
+// Fine path of one primary; hard[k] marks a hard deflection at point k
+struct Track {
+    std::vector<Vec3> p;
+    std::vector<char> hard;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+Vec3 Normalized(const Vec3& v) {
+    const double n = std::sqrt(v.x() * v.x() + v.y() * v.y() + v.z() * v.z());
+    return v * (1.0 / n);
+}
+
+double Length(const Vec3& v) {
+    return std::sqrt(v.x() * v.x() + v.y() * v.y() + v.z() * v.z());
+}
+
+// Primaries enter at z = 0 around the pad centre heading down, and stop after
+// rangeNm of path or where they would leave the grid.
+std::vector<Track> MakeTracks(const Options& o, const VoxelGrid& grid) {
+    std::mt19937_64 rng(o.seed);
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+
+    const Vec3 lo = grid.Min(), hi = grid.Max();
+    const double spot = (hi.x() - lo.x()) / 8.0;
+    const double fine = o.fineNm * nm;
+    const double sigma = o.diffusion * std::sqrt(o.fineNm);
+    const double pHard = o.fineNm / o.mfpNm;
+    const int nFine = (int)std::ceil(o.rangeNm / o.fineNm);
+
+    std::vector<Track> tracks(o.primaries);
+    for (auto& t : tracks) {
+        Vec3 q(spot * gauss(rng), spot * gauss(rng), hi.z() - 1e-6 * nm);
+        Vec3 dir = Normalized(Vec3(0.3 * gauss(rng), 0.3 * gauss(rng), -1.0));
+        t.p.push_back(q);
+        t.hard.push_back(0);
+        for (int k = 0; k < nFine; ++k) {
+            const bool hard = uni(rng) < pHard;
+            const double s = hard ? 1.5 : sigma;
+            dir = Normalized(dir + Vec3(gauss(rng), gauss(rng), gauss(rng)) * s);
+            const Vec3 next = q + dir * fine;
+            if (!grid.Contains(next)) break;
+            q = next;
+            t.p.push_back(q);
+            t.hard.push_back(hard ? 1 : 0);
+        }
+    }
+    return tracks;
+}
+
+// Run deposit (eV) of all primaries, one event each
+struct Result {
+    std::vector<double> edep;
+    double steps = 0.0, seconds = 0.0;
+};
+
+// limit < 0: the fine path itself (reference)
+Result Score(const Options& o, const VoxelGrid& shape, const std::vector<Track>& tracks,
+             double limitNm, bool split) {
+    VoxelGrid grid;
+    grid.ConfigureEventAccumulators(shape);
+    Result r;
+    r.edep.assign((size_t)shape.Nx() * shape.Ny() * shape.Nz(), 0.0);
+    const double limit = limitNm * nm;
+    const double dEdx = o.dEdx_eVnm * eV / nm;
+
+    // Steps first, so the timing covers scoring only
+    std::vector<std::pair<size_t, size_t>> steps;   // fine point range of each step
+    std::vector<double> lengths;
+    EventRecord rec;
+    for (const auto& t : tracks) {
+        steps.clear();
+        lengths.clear();
+        size_t k0 = 0;
+        double len = 0.0;
+        for (size_t k = 1; k < t.p.size(); ++k) {
+            len += Length(t.p[k] - t.p[k - 1]);
+            if (limitNm < 0.0 || t.hard[k] || (limit > 0.0 && len >= limit) || k + 1 == t.p.size()) {
+                steps.emplace_back(k0, k);
+                lengths.push_back(len);
+                k0 = k;
+                len = 0.0;
+            }
+        }
+
+        const auto t0 = Clock::now();
+        for (size_t s = 0; s < steps.size(); ++s) {
+            const Vec3& a = t.p[steps[s].first];
+            const Vec3& b = t.p[steps[s].second];
+            if (split) {
+                grid.AddSegment(a, b, dEdx * lengths[s]);
+            } else {
+                grid.AddEdep(0.5 * (a + b), dEdx * lengths[s]);
+            }
+        }
+        grid.FillEventRecord(rec);
+        grid.ResetEventAccumulators();
+        r.seconds += Seconds(t0);
+        r.steps += (double)steps.size();
+
+        // Row-major (logical) order whatever the storage layout
+        for (size_t k = 0; k < rec.Size(); ++k) {
+            const VoxelGrid::Index3 c = shape.Unflatten(rec.flat[k]);
+            r.edep[(size_t)c.iz + (size_t)shape.Nz() * ((size_t)c.iy + (size_t)shape.Ny() * (size_t)c.ix)] += rec.edep_eV[k];
+        }
+    }
+    return r;
+}
+
+// sum |a - ref| / sum ref over voxels and over the depth profile
+void Errors(const VoxelGrid& grid, const std::vector<double>& a, const std::vector<double>& ref,
+            double& voxelL1, double& depthL1) {
+    const int nz = grid.Nz();
+    std::vector<double> da(nz, 0.0), dr(nz, 0.0);
+    double diff = 0.0, total = 0.0;
+    for (size_t i = 0; i < ref.size(); ++i) {
+        diff += std::fabs(a[i] - ref[i]);
+        total += ref[i];
+        da[i % nz] += a[i];
+        dr[i % nz] += ref[i];
+    }
+    voxelL1 = diff / total;
+    double ddiff = 0.0;
+    for (int z = 0; z < nz; ++z) ddiff += std::fabs(da[z] - dr[z]);
+    depthL1 = ddiff / total;
+}
+
+std::vector<double> ParseList(const std::string& val) {
+    std::vector<double> out;
+    std::stringstream ss(val);
+    std::string item;
+    while (std::getline(ss, item, ',')) out.push_back(std::stod(item));
+    return out;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto eq = arg.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Expected key=value, got '" << arg << "'\n";
+            return 1;
+        }
+        const std::string key = arg.substr(0, eq), val = arg.substr(eq + 1);
+        if      (key == "limits")    o.limits = ParseList(val);
+        else if (key == "nxy")       o.nxy = std::stoi(val);
+        else if (key == "nz")        o.nz = std::stoi(val);
+        else if (key == "dxyNm")     o.dxyNm = std::stod(val);
+        else if (key == "dzNm")      o.dzNm = std::stod(val);
+        else if (key == "primaries") o.primaries = std::stoi(val);
+        else if (key == "rangeNm")   o.rangeNm = std::stod(val);
+        else if (key == "dEdx_eVnm") o.dEdx_eVnm = std::stod(val);
+        else if (key == "fineNm")    o.fineNm = std::stod(val);
+        else if (key == "diffusion") o.diffusion = std::stod(val);
+        else if (key == "mfpNm")     o.mfpNm = std::stod(val);
+        else if (key == "seed")      o.seed = std::stoull(val);
+        else {
+            std::cerr << "Unknown option '" << key << "'\n";
+            return 1;
+        }
+    }
+
+    try {
+        const double hx = 0.5 * o.nxy * o.dxyNm * nm;
+        VoxelGrid grid;
+        grid.Configure(Vec3(-hx, -hx, -o.nz * o.dzNm * nm), Vec3(hx, hx, 0.0),
+                       o.dxyNm * nm, o.dxyNm * nm, o.dzNm * nm);
+        const auto tracks = MakeTracks(o, grid);
+        const Result ref = Score(o, grid, tracks, -1.0, true);
+
+        std::cout << "grid " << grid.Nx() << " x " << grid.Ny() << " x " << grid.Nz()
+                  << ", " << o.primaries << " primaries, reference "
+                  << ref.steps / o.primaries << " fine steps/primary\n";
+        std::cout << std::setw(10) << "limit_nm" << std::setw(10) << "mode"
+                  << std::setw(16) << "steps/primary" << std::setw(14) << "voxel_L1"
+                  << std::setw(14) << "depth_L1" << std::setw(14) << "ns/primary" << "\n";
+        for (double limit : o.limits) {
+            for (bool split : {false, true}) {
+                const Result r = Score(o, grid, tracks, limit, split);
+                double voxelL1 = 0.0, depthL1 = 0.0;
+                Errors(grid, r.edep, ref.edep, voxelL1, depthL1);
+                std::cout << std::setw(10) << (limit > 0.0 ? std::to_string(limit).substr(0, 4) : "none")
+                          << std::setw(10) << (split ? "split" : "midpoint")
+                          << std::setw(16) << std::fixed << std::setprecision(1) << r.steps / o.primaries
+                          << std::setw(14) << std::scientific << std::setprecision(3) << voxelL1
+                          << std::setw(14) << depthL1
+                          << std::setw(14) << std::fixed << std::setprecision(0) << 1e9 * r.seconds / o.primaries
+                          << "\n";
+            }
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+    return 0;
+}